@@ -0,0 +1,9 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+// Process wide operator new counters, the benchmark replaces the global
+// operator new/delete to count every C++ heap allocation
+extern std::atomic<uint64_t> allocationCount;
+extern std::atomic<uint64_t> allocationBytes;
@@ -0,0 +1,388 @@
+#include "BenchApp.h"
+#include "Allocations.h"
+#include "ofxYolo.h"
+#include "OnnxYolo.h"
+
+namespace {
+    const char* USAGE =
+        "usage: bench <video file | image folder> [options]\n"
+        "  --frames N         frames to measure (default: whole input, looped if longer)\n"
+        "  --warmup N         frames run before measuring (default 10)\n"
+        "  --grain N          detect every N frames like Detection frameGrain (default 1)\n"
+        "  --fps F            simulated capture rate (default 30)\n"
+        "  --backend NAME     tensorflow or onnx (default tensorflow)\n"
+        "  --model PATH       model folder or .onnx file (default: the app's bin/data)\n"
+        "  --classes PATH     class names file (default: the app's bin/data/classes.txt)\n"
+        "  --area X,Y,W,H     detection area in frame pixels (default: whole frame)\n"
+        "  --resize F         Detection pixelsResize, snapped to 1 / sample step (default 1)\n"
+        "  --bilinear         bilinear instead of area filtered detection input\n"
+        "  --grid ROWS,COLS   grid size for the geometry stage (default 64,64)\n"
+        "  --out PATH         write JSON here instead of stdout\n"
+        "   or: bench --grid-kernel [--iterations N] [--out PATH]\n"
+        "  --grid-kernel      micro-benchmark the grid source rect kernel on 64x64 and 256x256 grids\n"
+        "  --iterations N     timed samples per grid and path (default 1000)\n";
+
+    // Same person filter as the app's defaults
+    const float MIN_CONFIDENCE = 0.5;
+    const float MIN_SIZE = 0.2;
+    const float MAX_MOVEMENT = 0.75;
+    const float MIN_MOVEMENT = 0.02;
+    const uint64_t INACTIVE_TIMEOUT = 10000;
+    const uint64_t EXPIRY_TIME = 60000;
+
+    float percentile(const vector<float>& sorted, float p) {
+        if (sorted.empty()) {
+            return 0;
+        }
+        size_t rank = std::ceil(p * sorted.size());
+        return sorted[std::min(sorted.size(), std::max<size_t>(rank, 1)) - 1];
+    }
+}
+
+bool BenchApp::parseArguments(int argc, char* argv[], Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--bilinear") {
+            options.areaFilter = false;
+        } else if (arg == "--grid-kernel") {
+            options.gridKernel = true;
+        } else if (arg.rfind("--", 0) == 0 && !hasValue) {
+            std::cerr << "missing value for " << arg << "\n" << USAGE;
+            return false;
+        } else if (arg == "--frames") {
+            options.frames = ofToInt(argv[++i]);
+        } else if (arg == "--warmup") {
+            options.warmup = ofToInt(argv[++i]);
+        } else if (arg == "--grain") {
+            options.frameGrain = std::max(1, ofToInt(argv[++i]));
+        } else if (arg == "--fps") {
+            options.frameRate = std::max(1.f, ofToFloat(argv[++i]));
+        } else if (arg == "--backend") {
+            options.backend = argv[++i];
+        } else if (arg == "--model") {
+            options.model = argv[++i];
+        } else if (arg == "--classes") {
+            options.classes = argv[++i];
+        } else if (arg == "--area") {
+            vector<string> values = ofSplitString(argv[++i], ",");
+            if (values.size() != 4) {
+                std::cerr << "--area needs X,Y,W,H\n" << USAGE;
+                return false;
+            }
+            options.area.set(ofToFloat(values[0]), ofToFloat(values[1]), ofToFloat(values[2]), ofToFloat(values[3]));
+        } else if (arg == "--resize") {
+            options.pixelsResize = InputPreprocessor::quantizeDensity(ofClamp(ofToFloat(argv[++i]), 0.2, 1.0));
+        } else if (arg == "--grid") {
+            vector<string> values = ofSplitString(argv[++i], ",");
+            if (values.size() != 2) {
+                std::cerr << "--grid needs ROWS,COLS\n" << USAGE;
+                return false;
+            }
+            options.rows = ofClamp(ofToInt(values[0]), 1, GridLayout::MAX_ROWS);
+            options.cols = ofClamp(ofToInt(values[1]), 1, GridLayout::MAX_COLS);
+        } else if (arg == "--iterations") {
+            options.iterations = std::max(1, ofToInt(argv[++i]));
+        } else if (arg == "--out") {
+            options.output = argv[++i];
+        } else if (arg.rfind("--", 0) == 0) {
+            std::cerr << "unknown option " << arg << "\n" << USAGE;
+            return false;
+        } else {
+            options.input = arg;
+        }
+    }
+    if (options.input.empty() && !options.gridKernel) {
+        std::cerr << USAGE;
+        return false;
+    }
+    return true;
+}
+
+BenchApp::BenchApp(const Options& benchOptions) : options(benchOptions) {
+    copy.name = "copy";
+    resize.name = "resize";
+    motion.name = "motion";
+    flow.name = "flow";
+    preprocess.name = "preprocess";
+    inference.name = "inference";
+    parse.name = "parse";
+    parse.countsAllocations = false; // Runs inside inference, its allocations are counted there
+    tracking.name = "tracking";
+    grid.name = "grid";
+    stages = {&copy, &resize, &motion, &flow, &preprocess, &inference, &parse, &tracking, &grid};
+}
+
+void BenchApp::setup() {
+    // Keep stdout clean for the JSON
+    ofSetLogLevel(options.output.empty() ? OF_LOG_ERROR : OF_LOG_NOTICE);
+
+    if (!openInput() || !readFrame(input)) {
+        ofLogError("bench") << "can't read frames from " << options.input;
+        ofExit(EXIT_FAILURE);
+        return;
+    }
+    int width = input.getWidth();
+    int height = input.getHeight();
+    if (options.area.isEmpty()) {
+        options.area.set(0, 0, width, height);
+    }
+
+    // Same setup as ofApp::setup()
+    framePool.allocate(4, width, height, input.getPixelFormat());
+    float aspectRatio = width / static_cast<float>(height);
+    displayPixels.allocate(options.outputHeight * aspectRatio, options.outputHeight, input.getPixelFormat());
+
+    string dataFolder = "../../../bin/data/"; // The app's bin/data, relative to bench/bin/data
+    if (options.backend == "onnx") {
+#ifdef BLOWUP_ONNXRUNTIME
+        detector = std::make_unique<OnnxYolo>();
+#else
+        ofLogError("bench") << "built without BLOWUP_ONNXRUNTIME, see config.make";
+        ofExit(EXIT_FAILURE);
+        return;
+#endif
+    } else {
+#ifndef BLOWUP_NO_TENSORFLOW
+        detector = std::make_unique<ofxYolo>();
+#else
+        ofLogError("bench") << "built without TensorFlow (BLOWUP_NO_TENSORFLOW), use --backend onnx";
+        ofExit(EXIT_FAILURE);
+        return;
+#endif
+    }
+    string model = options.model.empty() ? dataFolder + (options.backend == "onnx" ? "model.onnx" : "model") : options.model;
+    string classes = options.classes.empty() ? dataFolder + "classes.txt" : options.classes;
+    if (!detector->setup(model, classes)) {
+        ofLogError("bench") << "failed to set up " << model;
+        ofExit(EXIT_FAILURE);
+        return;
+    }
+    detector->setNormalize(true);
+    detector->setClassFilter({"person"});
+
+    tracker.setup();
+    gridLayout.setGrid(options.rows, options.cols, options.outputWidth / static_cast<float>(options.cols),
+                       options.outputHeight / static_cast<float>(options.rows));
+    gridLayout.setImage(width, height, 1.f / options.zoomFactor);
+    ofSeedRandom(0); // Same offsets on every run
+    gridLayout.randomizeOffsets(0.2, 0.05);
+    gridRenderer.setSourceSize(width, height);
+
+    int frames = options.frames;
+    if (frames <= 0) {
+        frames = player.isLoaded() ? player.getTotalNumFrames() : images.size();
+    }
+    if (frames <= 0) {
+        frames = 300;
+    }
+    for (auto stage : stages) {
+        stage->samples.reserve(frames);
+    }
+
+    // Warm up caches, lazy allocations and the model's first runs, then measure
+    int index = 0;
+    for (int i = 0; i < options.warmup; ++i, ++index) {
+        runFrame(index, false);
+        readFrame(input);
+    }
+    uint64_t start = ofGetElapsedTimeMicros();
+    for (int i = 0; i < frames; ++i, ++index) {
+        runFrame(index, true);
+        if (i + 1 < frames && !readFrame(input)) {
+            ofLogWarning("bench") << "input ended after " << i + 1 << " frames";
+            break;
+        }
+    }
+    double wallSeconds = (ofGetElapsedTimeMicros() - start) * 1e-6;
+
+    report(wallSeconds);
+    ofExit(0);
+}
+
+bool BenchApp::openInput() {
+    ofDirectory folder(options.input);
+    if (folder.isDirectory()) {
+        folder.allowExt("png");
+        folder.allowExt("jpg");
+        folder.allowExt("jpeg");
+        folder.allowExt("bmp");
+        folder.listDir();
+        folder.sort();
+        for (auto& file : folder) {
+            images.push_back(file.getAbsolutePath());
+        }
+        return !images.empty();
+    }
+
+    player.setUseTexture(false);
+    if (!player.load(options.input)) {
+        return false;
+    }
+    player.setLoopState(OF_LOOP_NONE);
+    player.play();
+    player.setPaused(true); // Step frame by frame with nextFrame()
+    return true;
+}
+
+bool BenchApp::readFrame(ofPixels& pixels) {
+    if (!images.empty()) {
+        bool loaded = ofLoadImage(pixels, images[nextImage]);
+        nextImage = (nextImage + 1) % images.size(); // Loop when asked for more frames than there are images
+        return loaded;
+    }
+
+    if (player.getIsMovieDone() || (player.getTotalNumFrames() > 0 && player.getCurrentFrame() >= player.getTotalNumFrames() - 1)) {
+        player.firstFrame();
+    } else {
+        player.nextFrame();
+    }
+    for (int tries = 0; tries < 1000; ++tries) { // Decoding runs on the player's own thread
+        player.update();
+        if (player.isFrameNew()) {
+            pixels = player.getPixels();
+            return pixels.isAllocated();
+        }
+        ofSleepMillis(1);
+    }
+    return false;
+}
+
+template<typename Fn>
+void BenchApp::measure(Stage& stage, bool measuring, Fn&& fn) {
+    uint64_t allocations = allocationCount.load(std::memory_order_relaxed);
+    uint64_t bytes = allocationBytes.load(std::memory_order_relaxed);
+    uint64_t start = ofGetElapsedTimeMicros();
+    fn();
+    uint64_t micros = ofGetElapsedTimeMicros() - start;
+    if (measuring) {
+        stage.samples.push_back(micros * 0.001f);
+        stage.allocations += allocationCount.load(std::memory_order_relaxed) - allocations;
+        stage.bytes += allocationBytes.load(std::memory_order_relaxed) - bytes;
+    }
+}
+
+// One camera frame through ofApp::update(), processFrame() and draw()
+void BenchApp::runFrame(int index, bool measuring) {
+    uint64_t now = index * 1000 / options.frameRate;
+    const ofRectangle& area = options.area;
+
+    FramePool::Ref frame;
+    measure(copy, measuring, [&] {
+        frame = framePool.copyFrom(input);
+    });
+    if (!frame) {
+        return;
+    }
+    measure(resize, measuring, [&] {
+        frame->pixels.resizeTo(displayPixels);
+    });
+    measure(motion, measuring, [&] {
+        motionGate.update(frame->pixels, area);
+    });
+    measure(flow, measuring, [&] {
+        flowTracker.update(motionGate.getLuma(), motionGate.getGridWidth(), motionGate.getGridHeight());
+    });
+
+    if (index % options.frameGrain == 0) {
+        measure(preprocess, measuring, [&] {
+            preprocessor.process(frame->pixels, area, detector->getInputBuffer(), detector->getInputWidth(), detector->getInputHeight(),
+                                 options.areaFilter ? InputPreprocessor::AREA : InputPreprocessor::BILINEAR, options.pixelsResize);
+        });
+
+        // Detector::update() includes decoding, report the decode on its own and the rest as inference
+        uint64_t start = ofGetElapsedTimeMicros();
+        uint64_t allocations = allocationCount.load(std::memory_order_relaxed);
+        uint64_t bytes = allocationBytes.load(std::memory_order_relaxed);
+        detector->setPreprocessedInput(area.width, area.height);
+        bool updated = detector->update();
+        float totalMs = (ofGetElapsedTimeMicros() - start) * 0.001f;
+        if (measuring && updated) {
+            float parseMs = detector->getStats().parseMs;
+            inference.samples.push_back(totalMs - parseMs);
+            inference.allocations += allocationCount.load(std::memory_order_relaxed) - allocations;
+            inference.bytes += allocationBytes.load(std::memory_order_relaxed) - bytes;
+            parse.samples.push_back(parseMs);
+            inferences++;
+        }
+
+        measure(tracking, measuring, [&] {
+            // Same person filter and focus choice as ofApp::processFrame()
+            tracker.clearDetections();
+            for (auto& object : detector->getObjects()) {
+                float size = object.bbox.width * object.bbox.height;
+                if (object.ident.text == "person" && object.confidence >= MIN_CONFIDENCE && size > MIN_SIZE) {
+                    tracker.addDetection(object.bbox, glm::vec2((object.bbox.x + object.bbox.width) * 0.5, (object.bbox.y + object.bbox.height) * 0.5), size);
+                    if (measuring) {
+                        peopleSeen++;
+                    }
+                }
+            }
+            tracker.update(now, MAX_MOVEMENT, MIN_MOVEMENT);
+            tracker.expire(now, EXPIRY_TIME);
+
+            float domSize = 0;
+            const Tracker::Track* target = nullptr;
+            for (auto& track : tracker.getTracks()) {
+                if (now - track.moveTimestamp < INACTIVE_TIMEOUT && track.size > domSize) {
+                    domSize = track.size;
+                    target = &track;
+                }
+            }
+            if (target) {
+                targetFocus = target->predict(now);
+                float step = motionGate.getStep();
+                flowTracker.setAnchor(ofRectangle((area.x + target->box.x * area.width) / step, (area.y + target->box.y * area.height) / step,
+                                                  target->box.width * area.width / step, target->box.height * area.height / step));
+            }
+        });
+    }
+    frame.reset();
+
+    measure(grid, measuring, [&] {
+        gridRenderer.clear();
+        gridLayout.build(1, targetFocus, gridRenderer);
+    });
+}
+
+void BenchApp::report(double wallSeconds) {
+    ofJson json;
+    json["input"] = options.input;
+    json["width"] = input.getWidth();
+    json["height"] = input.getHeight();
+    json["backend"] = detector->getName();
+    json["frameGrain"] = options.frameGrain;
+    json["pixelsResize"] = options.pixelsResize;
+    json["areaFilter"] = options.areaFilter;
+    json["grid"] = {options.rows, options.cols};
+    json["threads"] = std::thread::hardware_concurrency();
+    json["frames"] = copy.samples.size();
+    json["inferences"] = inferences;
+    json["peopleSeen"] = peopleSeen;
+    json["wallSeconds"] = wallSeconds;
+    json["framesPerSecond"] = wallSeconds > 0 ? copy.samples.size() / wallSeconds : 0;
+    json["inferencesPerSecond"] = wallSeconds > 0 ? inferences / wallSeconds : 0;
+
+    for (auto stage : stages) {
+        vector<float> sorted = stage->samples;
+        std::sort(sorted.begin(), sorted.end());
+        double total = std::accumulate(sorted.begin(), sorted.end(), 0.0);
+        ofJson& result = json["stages"][stage->name];
+        result["count"] = sorted.size();
+        result["meanMs"] = sorted.empty() ? 0 : total / sorted.size();
+        result["p50Ms"] = percentile(sorted, 0.50);
+        result["p95Ms"] = percentile(sorted, 0.95);
+        result["p99Ms"] = percentile(sorted, 0.99);
+        result["maxMs"] = sorted.empty() ? 0 : sorted.back();
+        if (stage->countsAllocations) {
+            result["allocationsPerCall"] = sorted.empty() ? 0 : stage->allocations / static_cast<double>(sorted.size());
+            result["allocatedBytesPerCall"] = sorted.empty() ? 0 : stage->bytes / static_cast<double>(sorted.size());
+        }
+    }
+
+    if (options.output.empty()) {
+        std::cout << json.dump(2) << std::endl;
+    } else if (!ofSavePrettyJson(options.output, json)) {
+        ofLogError("bench") << "failed to write " << options.output;
+    }
+}
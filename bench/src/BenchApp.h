@@ -0,0 +1,85 @@
+#pragma once
+
+#include "ofMain.h"
+#include "Detector.h"
+#include "FramePool.h"
+#include "InputPreprocessor.h"
+#include "MotionGate.h"
+#include "FlowTracker.h"
+#include "Tracker.h"
+#include "GridLayout.h"
+#include "GridRenderer.h"
+
+// Replays a video file or image sequence through the same stages as ofApp's
+// update(), processFrame() and draw() without a camera, display or window and
+// reports per-stage latency percentiles, throughput and allocations as JSON
+class BenchApp : public ofBaseApp {
+public:
+    struct Options {
+        string input;                  // Video file or folder of images
+        string output;                 // JSON file, stdout if empty
+        int frames = 0;                // Frames to measure, 0 for the whole input
+        int warmup = 10;               // Frames run before measuring
+        int frameGrain = 1;            // Run detection every frameGrain frames, like ofApp
+        float frameRate = 30;          // Simulated capture rate for the trackers' clocks
+        string backend = "tensorflow"; // "tensorflow" or "onnx"
+        string model;                  // Defaults to the app's bin/data model
+        string classes;
+        ofRectangle area;              // Detection area, defaults to the whole frame
+        float pixelsResize = 1;
+        bool areaFilter = true;
+        int rows = 64, cols = 64;      // Grid size for the geometry stage
+        int outputWidth = 1920, outputHeight = 1080;
+        int zoomFactor = 4;
+        bool gridKernel = false;       // Run KernelBench instead
+        int iterations = 1000;         // KernelBench samples per grid and path
+    };
+
+    // Fill options from the command line, prints usage and returns false on errors
+    static bool parseArguments(int argc, char* argv[], Options& options);
+
+    BenchApp(const Options& options);
+
+    void setup() override;
+
+private:
+    struct Stage {
+        string name;
+        vector<float> samples; // Milliseconds
+        uint64_t allocations = 0;
+        uint64_t bytes = 0;
+        bool countsAllocations = true;
+    };
+
+    bool openInput();
+    bool readFrame(ofPixels& pixels);
+    void runFrame(int index, bool measuring);
+    void report(double wallSeconds);
+
+    // Time fn into stage and count its allocations, only while measuring
+    template<typename Fn>
+    void measure(Stage& stage, bool measuring, Fn&& fn);
+
+    Options options;
+
+    ofVideoPlayer player;
+    vector<string> images;
+    size_t nextImage = 0;
+    ofPixels input;
+
+    FramePool framePool;
+    ofPixels displayPixels;
+    InputPreprocessor preprocessor;
+    std::unique_ptr<Detector> detector;
+    MotionGate motionGate;
+    FlowTracker flowTracker;
+    Tracker tracker;
+    GridRenderer gridRenderer;
+    GridLayout gridLayout;
+    glm::vec2 targetFocus = glm::vec2(0.5, 0.5);
+
+    Stage copy, resize, motion, flow, preprocess, inference, parse, tracking, grid;
+    vector<Stage*> stages;
+    int inferences = 0;
+    int peopleSeen = 0;
+};
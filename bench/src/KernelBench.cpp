@@ -0,0 +1,119 @@
+#include "KernelBench.h"
+#include "GridKernel.h"
+#include "GridLayout.h"
+#include "GridRenderer.h"
+
+namespace {
+    const int IMAGE_WIDTH = 3840;
+    const int IMAGE_HEIGHT = 2160;
+    const int OUTPUT_WIDTH = 1920;
+    const int OUTPUT_HEIGHT = 1080;
+    const float SCALE_FACTOR = 0.25;
+    const int RUNS_PER_SAMPLE = 16; // One call on a small grid is below the clock's useful resolution
+
+    uint64_t nowNanos() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    // Nanoseconds per call of fn over iterations samples
+    template<typename Fn>
+    ofJson measure(int iterations, size_t cells, Fn&& fn) {
+        vector<double> samples;
+        samples.reserve(iterations);
+        for (int i = 0; i < iterations; ++i) {
+            uint64_t start = nowNanos();
+            for (int run = 0; run < RUNS_PER_SAMPLE; ++run) {
+                fn(run);
+            }
+            samples.push_back((nowNanos() - start) / static_cast<double>(RUNS_PER_SAMPLE));
+        }
+        std::sort(samples.begin(), samples.end());
+        double mean = std::accumulate(samples.begin(), samples.end(), 0.0) / samples.size();
+        ofJson result;
+        result["meanNs"] = mean;
+        result["p50Ns"] = samples[samples.size() / 2];
+        result["p95Ns"] = samples[std::min(samples.size() - 1, static_cast<size_t>(samples.size() * 0.95))];
+        result["nsPerCell"] = mean / cells;
+        return result;
+    }
+}
+
+int KernelBench::run(int iterations, const string& output) {
+    ofJson json;
+    json["instructionSet"] = GridKernel::getInstructionSet();
+    json["iterations"] = iterations;
+    bool agree = true;
+
+    for (int size : {64, 256}) {
+        size_t n = static_cast<size_t>(size) * size;
+
+        // Inputs shaped like GridLayout's for an unmerged grid with random offsets
+        ofSeedRandom(0);
+        vector<float> zoomWidth(n, IMAGE_WIDTH * SCALE_FACTOR), zoomHeight(n), centerX(n), centerY(n), offsetX(n), offsetY(n);
+        float cellWidth = OUTPUT_WIDTH / static_cast<float>(size), cellHeight = OUTPUT_HEIGHT / static_cast<float>(size);
+        for (size_t i = 0; i < n; ++i) {
+            zoomHeight[i] = zoomWidth[i] * cellHeight / cellWidth;
+            centerX[i] = (i % size + 0.5f) * cellWidth;
+            centerY[i] = (i / size + 0.5f) * cellHeight;
+            offsetX[i] = IMAGE_WIDTH * ofRandom(-0.2, 0.2);
+            offsetY[i] = IMAGE_HEIGHT * ofRandom(-0.05, 0.05);
+        }
+        GridKernel::Cells cells = {zoomWidth.data(), zoomHeight.data(), centerX.data(), centerY.data(), offsetX.data(), offsetY.data()};
+        vector<float> scalar(n * 4), vectorized(n * 4);
+        GridKernel::SourceRects scalarRects = {scalar.data(), scalar.data() + n, scalar.data() + n * 2, scalar.data() + n * 3};
+        GridKernel::SourceRects vectorRects = {vectorized.data(), vectorized.data() + n, vectorized.data() + n * 2, vectorized.data() + n * 3};
+
+        // Vary rampy and focus between runs like a transition would
+        auto params = [](int run) {
+            GridKernel::Params params;
+            params.rampy = (run + 1) / static_cast<float>(RUNS_PER_SAMPLE);
+            params.focus = glm::vec2(0.3f + run * 0.02f, 0.6f);
+            params.imageWidth = IMAGE_WIDTH;
+            params.imageHeight = IMAGE_HEIGHT;
+            return params;
+        };
+
+        float maxDifference = 0;
+        for (int run = 0; run < RUNS_PER_SAMPLE; ++run) {
+            GridKernel::computeSourceRectsScalar(n, cells, params(run), scalarRects);
+            GridKernel::computeSourceRects(n, cells, params(run), vectorRects);
+            for (size_t i = 0; i < n * 4; ++i) {
+                maxDifference = std::max(maxDifference, std::abs(scalar[i] - vectorized[i]));
+            }
+        }
+        agree = agree && maxDifference < 0.01f;
+
+        GridLayout layout;
+        layout.setGrid(size, size, cellWidth, cellHeight);
+        layout.setImage(IMAGE_WIDTH, IMAGE_HEIGHT, SCALE_FACTOR);
+        layout.randomizeOffsets(0.2, 0.05);
+        GridRenderer renderer;
+
+        ofJson& result = json["grids"][ofToString(size) + "x" + ofToString(size)];
+        result["cells"] = n;
+        result["maxDifferencePixels"] = maxDifference;
+        result["scalar"] = measure(iterations, n, [&](int run) {
+            GridKernel::computeSourceRectsScalar(n, cells, params(run), scalarRects);
+        });
+        result["vector"] = measure(iterations, n, [&](int run) {
+            GridKernel::computeSourceRects(n, cells, params(run), vectorRects);
+        });
+        result["layoutBuild"] = measure(iterations, n, [&](int run) {
+            renderer.clear();
+            layout.build(params(run).rampy, params(run).focus, renderer);
+        });
+        result["vectorSpeedup"] = result["scalar"]["meanNs"].get<double>() / result["vector"]["meanNs"].get<double>();
+    }
+
+    if (output.empty()) {
+        std::cout << json.dump(2) << std::endl;
+    } else if (!ofSavePrettyJson(output, json)) {
+        ofLogError("bench") << "failed to write " << output;
+        return EXIT_FAILURE;
+    }
+    if (!agree) {
+        ofLogError("bench") << "vector and scalar source rects differ";
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
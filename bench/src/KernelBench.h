@@ -0,0 +1,12 @@
+#pragma once
+
+#include "ofMain.h"
+
+// Micro-benchmark of the grid's per-frame source rect kernel on full 64x64
+// and 256x256 grids: the scalar reference, the vector path this CPU runs and
+// GridLayout::build() including the renderer's mesh fill. Reports ns per
+// call and per cell as JSON, and fails if the paths disagree.
+namespace KernelBench {
+    // Returns the process exit code
+    int run(int iterations, const string& output);
+}
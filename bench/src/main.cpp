@@ -0,0 +1,20 @@
+#include "ofMain.h"
+#include "ofAppNoWindow.h"
+#include "BenchApp.h"
+#include "KernelBench.h"
+
+//========================================================================
+int main(int argc, char* argv[]) {
+	BenchApp::Options options;
+	if (!BenchApp::parseArguments(argc, argv, options)) {
+		return EXIT_FAILURE;
+	}
+	if (options.gridKernel) {
+		return KernelBench::run(options.iterations, options.output);
+	}
+
+	// No window or GL context, everything the benchmark runs is CPU side
+	auto window = std::make_shared<ofAppNoWindow>();
+	ofRunApp(window, std::make_shared<BenchApp>(options));
+	return ofRunMainLoop();
+}
@@ -0,0 +1,77 @@
+#include "AdaptiveScheduler.h"
+
+void AdaptiveScheduler::setup(const Settings& newSettings, int initialFrameGrain) {
+    settings = newSettings;
+    frameGrain = ofClamp(initialFrameGrain, settings.minFrameGrain, settings.maxFrameGrain);
+    renderSlow = false;
+    periodStart = 0;
+}
+
+bool AdaptiveScheduler::update(uint64_t nowMillis, double frameSeconds, uint64_t detections, float detectionMs, bool gated) {
+    if (periodStart == 0) { // First call, start measuring
+        periodStart = nowMillis;
+        periodDetections = detections;
+        return false;
+    }
+
+    periodFrameSeconds += frameSeconds;
+    periodFrames++;
+    periodGated = periodGated || gated;
+    periodDetectionMs = std::max(periodDetectionMs, detectionMs);
+
+    uint64_t elapsed = nowMillis - periodStart;
+    if (elapsed < settings.evaluationInterval || periodFrames == 0) {
+        return false;
+    }
+
+    detectionRate = (detections - periodDetections) * 1000.f / elapsed;
+    renderRate = periodFrameSeconds > 0 ? periodFrames / periodFrameSeconds : 0;
+
+    int lastFrameGrain = frameGrain;
+    // Hysteresis between starving and recovered, a 60 fps target measures a little under 60 under vsync
+    if (renderRate < settings.targetRenderRate * settings.renderSlowRate) {
+        renderSlow = true;
+    } else if (renderRate >= settings.targetRenderRate * settings.renderRecoveredRate) {
+        renderSlow = false;
+    }
+    bool detectionSlow = detectionRate < settings.targetDetectionRate * 0.9f;
+    bool detectionFast = detectionRate > settings.targetDetectionRate * 1.1f;
+    bool inferenceBound = periodDetectionMs * settings.targetDetectionRate > 1000; // Can't reach the target however often we submit
+
+    if (renderSlow) {
+        // Render is starving, shed detection load with fewer detections
+        if (frameGrain < settings.maxFrameGrain) {
+            frameGrain++;
+            lastAction = "render slow, grain +1";
+        } else {
+            lastAction = "render slow, grain at max";
+        }
+    } else if (detectionSlow && !periodGated) {
+        if (inferenceBound) {
+            // Submitting more often only drops more frames in the mailbox
+            lastAction = "detection slow, inference bound";
+        } else if (frameGrain > settings.minFrameGrain) {
+            frameGrain--;
+            lastAction = "detection slow, grain -1";
+        }
+    } else if (detectionFast && !periodGated && detectionRate * frameGrain / (frameGrain + 1) >= settings.targetDetectionRate * 0.9f) {
+        // Only back off if the next grain still meets the target, otherwise we'd oscillate
+        frameGrain++;
+        lastAction = "detection fast, grain +1";
+    }
+
+    frameGrain = ofClamp(frameGrain, settings.minFrameGrain, settings.maxFrameGrain);
+
+    periodStart = nowMillis;
+    periodDetections = detections;
+    periodFrameSeconds = 0;
+    periodFrames = 0;
+    periodGated = false;
+    periodDetectionMs = 0;
+
+    return frameGrain != lastFrameGrain;
+}
+
+std::string AdaptiveScheduler::getDescription() const {
+    return "grain " + ofToString(frameGrain) + ", " + ofToString(detectionRate, 1) + " det/s, " + ofToString(renderRate, 0) + " fps (" + lastAction + ")";
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "ofMain.h"
+
+// Tunes the detection cadence (frameGrain) at runtime from measured render
+// frame times and detection throughput, aiming for a target detection rate
+// without letting the render rate drop below target. The model input has a
+// fixed size, so frameGrain is the only knob that changes detection load.
+class AdaptiveScheduler {
+public:
+    struct Settings {
+        float targetDetectionRate = 10; // Detections per second
+        float targetRenderRate = 60;    // Render frames per second to protect
+        float renderSlowRate = 0.92;    // Fraction of targetRenderRate below which render counts as starving
+        float renderRecoveredRate = 0.97; // Fraction it has to climb back to, so vsync jitter doesn't shed load
+        int minFrameGrain = 1, maxFrameGrain = 6;
+        uint64_t evaluationInterval = 1000; // Milliseconds between adjustments
+    };
+
+    void setup(const Settings& settings, int frameGrain);
+
+    // Call once per render frame, returns true when frameGrain changed.
+    // frameSeconds is the last render frame time, detections the worker's processed
+    // count, detectionMs its last process time and gated whether the motion gate
+    // skipped inference since the last call.
+    bool update(uint64_t nowMillis, double frameSeconds, uint64_t detections, float detectionMs, bool gated);
+
+    void setTargetDetectionRate(float rate) { settings.targetDetectionRate = rate; }
+
+    int getFrameGrain() const { return frameGrain; }
+    float getDetectionRate() const { return detectionRate; }
+    float getRenderRate() const { return renderRate; }
+
+    // Human readable summary of the current choices
+    std::string getDescription() const;
+
+private:
+    Settings settings;
+    int frameGrain = 2;
+    bool renderSlow = false;
+
+    uint64_t periodStart = 0;
+    uint64_t periodDetections = 0;
+    double periodFrameSeconds = 0;
+    int periodFrames = 0;
+    bool periodGated = false;
+    float periodDetectionMs = 0;
+
+    float detectionRate = 0;
+    float renderRate = 0;
+    std::string lastAction = "-";
+};
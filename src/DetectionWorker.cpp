@@ -0,0 +1,103 @@
+#include "DetectionWorker.h"
+
+DetectionWorker::~DetectionWorker() {
+    shutdown();
+}
+
+void DetectionWorker::setup(std::function<void(FrameBatch&)> processFunction, std::function<void()> prepareFunction) {
+    process = processFunction;
+    prepare = prepareFunction;
+}
+
+void DetectionWorker::submit(FrameBatch batch) {
+    mailbox.getWriteBuffer() = std::move(batch);
+    if (mailbox.publish()) {
+        // The worker never picked up the previous batch, it's back in our hands
+        mailbox.getWriteBuffer().reset();
+        dropped++;
+    }
+    submitted++;
+
+    // Taking the lock orders this notify after a worker that's about to sleep has checked the mailbox
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+    }
+    wake.notify_one();
+}
+
+void DetectionWorker::requestTick() {
+    tickRequested = true;
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+    }
+    wake.notify_one();
+}
+
+void DetectionWorker::shutdown() {
+    if (isThreadRunning()) {
+        stopThread();
+        wake.notify_all();
+        waitForThread(false);
+    }
+
+    // Release frames still parked in the mailbox
+    mailbox.getWriteBuffer().reset();
+    if (mailbox.update()) {
+        mailbox.getReadBuffer().reset();
+    }
+}
+
+DetectionWorker::Stats DetectionWorker::getStats() const {
+    Stats stats;
+    stats.submitted = submitted;
+    stats.processed = processed;
+    stats.ticks = ticks;
+    stats.dropped = dropped;
+    stats.queueDepth = mailbox.hasNew() ? 1 : 0;
+    stats.frameAgeMs = frameAgeMs;
+    stats.avgFrameAgeMs = avgFrameAgeMs;
+    stats.processMs = processMs;
+    return stats;
+}
+
+void DetectionWorker::threadedFunction() {
+    if (prepare) {
+        prepare();
+    }
+    while (isThreadRunning()) {
+        {
+            std::unique_lock<std::mutex> lock(wakeMutex);
+            wake.wait_for(lock, std::chrono::milliseconds(100), [this] {
+                return mailbox.hasNew() || tickRequested || !isThreadRunning();
+            });
+        }
+        if (!mailbox.update()) {
+            if (tickRequested.exchange(false)) {
+                FrameBatch none;
+                process(none);
+                ticks++;
+            }
+            continue;
+        }
+        tickRequested = false; // A real frame covers the tick
+
+        FrameBatch batch = std::move(mailbox.getReadBuffer());
+        uint64_t start = ofGetElapsedTimeMicros();
+        uint64_t captureTime = start;
+        for (int i = 0; i < batch.size; ++i) {
+            if (batch.frames[i]) {
+                captureTime = std::min(captureTime, batch.frames[i]->captureTime);
+            }
+        }
+        float age = (start - captureTime) * 0.001f;
+        frameAgeMs = age;
+        avgFrameAgeMs = ofLerp(avgFrameAgeMs, age, 0.1);
+
+        busy = true;
+        process(batch);
+        busy = false;
+
+        processMs = (ofGetElapsedTimeMicros() - start) * 0.001f;
+        processed++;
+    }
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include "ofMain.h"
+#include "FramePool.h"
+#include "TripleBuffer.h"
+
+// Frames of one detection cycle, one per camera in camera order, inferred as
+// one batch. A camera without a frame has an empty Ref in its slot.
+struct FrameBatch {
+    static const int MAX_FRAMES = 8;
+
+    FramePool::Ref frames[MAX_FRAMES];
+    int size = 0;
+
+    // Append the next camera's frame, ignored once the batch is full
+    void add(FramePool::Ref frame) {
+        if (size < MAX_FRAMES) {
+            frames[size++] = std::move(frame);
+        }
+    }
+
+    // Release the frames
+    void reset() {
+        for (int i = 0; i < size; ++i) {
+            frames[i].reset();
+        }
+        size = 0;
+    }
+
+    explicit operator bool() const { return size > 0; }
+};
+
+// Long-lived detection thread fed through a single-slot mailbox: the main thread
+// submit()s frames without blocking, the worker always picks up the newest one
+// and frames it never got to are released and counted as dropped
+class DetectionWorker : public ofThread {
+public:
+    struct Stats {
+        uint64_t submitted = 0;
+        uint64_t processed = 0;
+        uint64_t ticks = 0;       // Process calls without a frame
+        uint64_t dropped = 0;     // Replaced in the mailbox before the worker took them
+        int queueDepth = 0;       // Frames waiting in the mailbox, 0 or 1
+        float frameAgeMs = 0;     // Capture to pickup for the oldest frame of the last processed batch
+        float avgFrameAgeMs = 0;  // Smoothed frameAgeMs
+        float processMs = 0;      // Duration of the last process call
+    };
+
+    ~DetectionWorker();
+
+    // Set the function run on the worker thread for every batch picked up,
+    // or with an empty batch for requestTick(), and optionally one run once on
+    // the thread before anything else, ie. to load a model without blocking
+    // the main thread. Batches submitted meanwhile wait in the mailbox.
+    void setup(std::function<void(FrameBatch&)> process, std::function<void()> prepare = nullptr);
+
+    // Hand the newest batch to the worker, replacing any batch still waiting
+    void submit(FrameBatch batch);
+
+    // Run process with an empty frame unless a real frame arrives first, so
+    // time based state advances while inference is skipped
+    void requestTick();
+
+    // Stop and join the thread, releasing any frame still waiting
+    void shutdown();
+
+    Stats getStats() const;
+
+    // True while process runs on a batch, for telling frames drawn during inference apart
+    bool isBusy() const { return busy; }
+
+protected:
+    void threadedFunction() override;
+
+private:
+    std::function<void(FrameBatch&)> process;
+    std::function<void()> prepare;
+    TripleBuffer<FrameBatch> mailbox;
+
+    // Only used to sleep while the mailbox is empty, never held while touching it
+    std::mutex wakeMutex;
+    std::condition_variable wake;
+
+    std::atomic<bool> tickRequested{false};
+    std::atomic<bool> busy{false};
+    std::atomic<uint64_t> submitted{0}, processed{0}, dropped{0}, ticks{0};
+    std::atomic<float> frameAgeMs{0}, avgFrameAgeMs{0}, processMs{0};
+};
@@ -0,0 +1,316 @@
+#pragma once
+
+#include "ofMain.h"
+#include "YoloDecoder.h"
+
+/// \class Detector
+/// \brief common interface for YOLO style object detector backends
+///
+/// a backend owns a persistent NN input buffer: write preprocessed pixels into
+/// getInputBuffer(), hand it over with setPreprocessedInput() and poll update()
+/// until it returns true, then read getObjects()
+///
+/// with setBatchSize() the buffer holds several images, ie. one per camera,
+/// which run through the model as one batched inference: write each into
+/// getBatchInputBuffer(), set its size with setBatchInputSize() and hand them
+/// over with setPreprocessedBatch(), then read getObjects() per image
+///
+/// class loading, output decoding and stats are shared by all backends,
+/// a backend only loads its model and runs inference
+class Detector {
+	public:
+
+		/// single detected object
+		struct Object {
+			/// identified object class
+			struct Ident {
+				int index;          ///< identified class index within classes vector, 0 to size-1
+				std::string & text; ///< identified class string, ie. "person", "car", etc
+				Ident(int index, std::string & text) : index(index), text(text) {}
+			} ident;
+			ofRectangle bbox; ///< bounding box, coords within input image size (default) or normalized 0-1
+			float confidence; ///< confidence 0-1
+
+			/// create with identified class index and string
+			Object(int index, std::string & text) : ident(index, text) {}
+
+			/// draw object bounding box and class info
+			void draw() {
+				drawBox();
+				drawClass();
+			}
+
+			/// draw object bounding box
+			void drawBox() {
+				ofNoFill();
+				ofSetColor(ofColor::hotPink);
+				ofDrawRectangle(bbox);
+			}
+
+			/// draw object class and confidence
+			void drawClass() {
+				ofSetColor(ofColor::cyan);
+				ofDrawBitmapString(ident.text + "\n" + ofToString(confidence, 2),
+				                   bbox.x, bbox.y);
+			}
+		};
+
+		/// inference timing, safe to read from any thread
+		struct Stats {
+			uint64_t inferences = 0;  ///< number of completed inferences
+			float inferenceMs = 0;    ///< duration of the last inference
+			float avgInferenceMs = 0; ///< smoothed inference duration
+			float parseMs = 0;        ///< duration of the last output decode
+			double totalInferenceMs = 0; ///< summed duration of all inferences
+		};
+
+		virtual ~Detector() {}
+
+		/// load and set up the model & load object class names from a txt file
+		/// (one name string per line), returns true on success
+		virtual bool setup(const std::string & modelPath, const std::string & classPath) = 0;
+
+		/// clear model and classes
+		virtual void clear() {classes_.clear();}
+
+		/// backend name for logging, ie. "tensorflow"
+		virtual std::string getName() const = 0;
+
+		/// input width expected by the model
+		virtual int getInputWidth() const = 0;
+
+		/// input height expected by the model
+		virtual int getInputHeight() const = 0;
+
+		/// returns the persistent model input buffer, getBatchSize() images of
+		/// getInputWidth() x getInputHeight() interleaved RGB floats 0-1
+		virtual float * getInputBuffer() = 0;
+
+		/// use the input buffer as the next input, width & height are the size
+		/// of the source region it was sampled from, used for bbox coords
+		void setPreprocessedInput(int width, int height) {
+			setBatchInputSize(0, width, height);
+			submitInput(1);
+		}
+
+		/// run the model on the current input if there is one,
+		/// returns true if objects are new
+		virtual bool update() = 0;
+
+		/// run the model runs times on a gray input of the full batch size so
+		/// the first real inference doesn't pay for one-time graph setup and
+		/// allocations, call after setup() while update() blocks,
+		/// returns the time taken in ms
+		float warmUp(int runs = 2) {
+			uint64_t start = ofGetElapsedTimeMicros();
+			float * input = getInputBuffer();
+			std::fill(input, input + (size_t)batchSize_ * getInputWidth() * getInputHeight() * 3, 0.5f);
+			for(int run = 0; run < runs; run++) {
+				for(int image = 0; image < batchSize_; image++) {
+					setBatchInputSize(image, getInputWidth(), getInputHeight());
+				}
+				submitInput(batchSize_);
+				update();
+			}
+			for(auto & objects : objects_) {
+				objects.clear();
+			}
+			return (ofGetElapsedTimeMicros() - start) * 0.001f;
+		}
+
+		/// returns a reference to the detected objects, of the given batch image
+		std::vector<Object> & getObjects(int image = 0) {return objects_[image];}
+
+		/// set the number of images per inference (default 1), call before setup();
+		/// a backend whose model can't batch falls back to 1, so check
+		/// getBatchSize() after setup()
+		void setBatchSize(int size) {
+			batchSize_ = std::max(1, size);
+			objects_.resize(batchSize_);
+			inputSizes_.resize(batchSize_);
+		}
+
+		/// returns the number of images per inference
+		int getBatchSize() const {return batchSize_;}
+
+		/// set the inference runtime's thread pool sizes, call before setup();
+		/// intraOp threads split up one operation, interOp threads run
+		/// independent operations side by side, 0 keeps the runtime's default,
+		/// which is usually one thread per core
+		void setNumThreads(int intraOp, int interOp) {
+			intraOpThreads_ = std::max(0, intraOp);
+			interOpThreads_ = std::max(0, interOp);
+		}
+
+		/// returns image's part of the input buffer, 0 to getBatchSize()-1
+		float * getBatchInputBuffer(int image) {
+			return getInputBuffer() + (size_t)image * getInputWidth() * getInputHeight() * 3;
+		}
+
+		/// set the size of the source region image was sampled from, used for its bbox coords
+		void setBatchInputSize(int image, int width, int height) {
+			inputSizes_[image].width = width;
+			inputSizes_[image].height = height;
+		}
+
+		/// use the first count images of the input buffer as the next input,
+		/// objects are then reported per image
+		void setPreprocessedBatch(int count) {
+			submitInput(ofClamp(count, 1, batchSize_));
+		}
+
+		/// returns a reference to the detected object class names
+		std::vector<std::string> & getClasses() {return classes_;}
+
+		/// only report objects whose best class is one of these, ie. {"person"},
+		/// rows are dropped while decoding, before NMS; an empty list reports all
+		/// classes (default), returns false if a class name is unknown
+		bool setClassFilter(const std::vector<std::string> & names) {
+			std::vector<int> mask;
+			for(auto & name : names) {
+				auto found = std::find(classes_.begin(), classes_.end(), name);
+				if(found == classes_.end()) {
+					ofLogWarning("Detector") << "unknown class filter " << name;
+					return false;
+				}
+				mask.push_back(found - classes_.begin());
+			}
+			decoder_.setClassMask(mask);
+			return true;
+		}
+
+		/// returns input width of the first image
+		/// bounding boxes are within this range
+		int getWidth() {return inputSizes_[0].width;}
+
+		/// returns input height of the first image
+		/// bounding boxes are within this range
+		int getHeight() {return inputSizes_[0].height;}
+
+		/// set minimum object confidence threshold 0-1 (default 0.2),
+		/// anything less will be ignored
+		void setThreshold(float confidence) {
+			threshold_ = ofClamp(confidence, 0, 1);
+		}
+
+		/// get the minimum object confidence threshold 0-1
+		float getThreshold() {return threshold_;}
+
+		/// set whether to normalize object bounding box coordinates
+		/// * true: within 0-1
+		/// * false: within image size 0-w, 0-h (default)
+		void setNormalize(bool normalize) {normalize_ = normalize;}
+
+		/// returns true if object bounding box coordinates are normalized 0-1
+		/// or false if within the image input size 0-w, 0-h
+		bool getNormalize() {return normalize_;}
+
+		/// returns inference timing
+		Stats getStats() const {
+			Stats stats;
+			stats.inferences = inferences_;
+			stats.inferenceMs = inferenceMs_;
+			stats.avgInferenceMs = avgInferenceMs_;
+			stats.parseMs = parseMs_;
+			stats.totalInferenceMs = totalInferenceMs_;
+			return stats;
+		}
+
+	protected:
+		std::vector<std::vector<Object>> objects_ = std::vector<std::vector<Object>>(1); ///< per batch image
+
+		/// hand the first count images of the input buffer to the model
+		virtual void submitInput(int count) = 0;
+
+		/// load object class names, returns true on success
+		bool loadClasses(const std::string & classPath, int numClasses) {
+			ofBuffer buffer = ofBufferFromFile(classPath);
+			if(buffer.size() == 0) {
+				ofLogError(getName()) << "failed to load " << classPath;
+				return false;
+			}
+			classes_.clear();
+			for(auto& line : buffer.getLines()) {
+				classes_.push_back(line);
+			}
+			decoder_.setup(numClasses);
+			return true;
+		}
+
+		/// parse numRows raw output rows (4 box coords + class scores) of count
+		/// batch images into objects, each image has numRows / count rows
+		void parseObjects(const float * data, size_t numRows, int count = 1) {
+			uint64_t start = ofGetElapsedTimeMicros();
+			size_t imageRows = numRows / count;
+			size_t rowSize = 4 + decoder_.getNumClasses();
+			for(int image = 0; image < count; image++) {
+				parseImage(data + image * imageRows * rowSize, imageRows, image);
+			}
+			for(int image = count; image < batchSize_; image++) {
+				objects_[image].clear();
+			}
+			parseMs_ = (ofGetElapsedTimeMicros() - start) * 0.001f;
+		}
+
+		/// record the duration of one inference
+		void recordInference(uint64_t micros) {
+			float ms = micros * 0.001f;
+			inferenceMs_ = ms;
+			avgInferenceMs_ = (inferences_ == 0 ? ms : ofLerp(avgInferenceMs_, ms, 0.1));
+			totalInferenceMs_ = totalInferenceMs_ + ms; // only the inference thread writes it
+			inferences_++;
+		}
+
+		struct Size {
+			int width = 1;
+			int height = 1;
+		};
+		std::vector<Size> inputSizes_ = std::vector<Size>(1); ///< pixel input size per batch image
+		int batchSize_ = 1; ///< images per inference
+		int intraOpThreads_ = 0; ///< runtime thread pool sizes, 0: the runtime's default
+		int interOpThreads_ = 0;
+
+	private:
+
+		/// decode one image's output rows into its objects
+		void parseImage(const float * data, size_t numRows, int image) {
+			auto & detections = decoder_.decode(data, numRows, threshold_, 10, 0.5);
+			const Size & inputSize = inputSizes_[image];
+			std::vector<Object> & objects = objects_[image];
+
+			// convert detected rectangles to Objects
+			objects.clear();
+			for(auto & detection : detections) {
+				int classIndex = detection.classIndex;
+				if(classIndex >= classes_.size()) {
+					ofLogWarning(getName()) << "ignoring unknown object class index " << classIndex;
+					continue;
+				}
+				Object object(classIndex, classes_[classIndex]);
+				if(normalize_) { // normalized bbox coords
+					object.bbox.x = detection.x1;
+					object.bbox.y = detection.y1;
+					object.bbox.width = detection.x2 - object.bbox.x;
+					object.bbox.height = detection.y2 - object.bbox.y;
+				}
+				else { // use input image size
+					object.bbox.x = detection.x1 * (float)inputSize.width;
+					object.bbox.y = detection.y1 * (float)inputSize.height;
+					object.bbox.width = (detection.x2 * (float)inputSize.width) - object.bbox.x;
+					object.bbox.height = (detection.y2 * (float)inputSize.height) - object.bbox.y;
+				}
+				object.confidence = detection.confidence;
+				objects.push_back(object);
+			}
+		}
+
+		std::vector<std::string> classes_; //< known object classes
+		bool normalize_ = false; ///< normalize bounding box coords?
+		float threshold_ = 0.2; ///< min object confidence threshold
+		YoloDecoder decoder_; ///< output decoder & NMS
+		std::atomic<uint64_t> inferences_{0};
+		std::atomic<float> inferenceMs_{0};
+		std::atomic<float> avgInferenceMs_{0};
+		std::atomic<float> parseMs_{0};
+		std::atomic<double> totalInferenceMs_{0};
+};
@@ -0,0 +1,229 @@
+#include "FlowTracker.h"
+
+float FlowTracker::Level::sample(float x, float y) const {
+    x = ofClamp(x, 0, width - 1.001f);
+    y = ofClamp(y, 0, height - 1.001f);
+    int x0 = static_cast<int>(x);
+    int y0 = static_cast<int>(y);
+    float fx = x - x0;
+    float fy = y - y0;
+    const float* p = data.data() + y0 * width + x0;
+    float top = p[0] + (p[1] - p[0]) * fx;
+    float bottom = p[width] + (p[width + 1] - p[width]) * fx;
+    return top + (bottom - top) * fy;
+}
+
+bool FlowTracker::update(const std::vector<unsigned char>& luma, int width, int height) {
+    if (width < 8 || height < 8 || luma.size() < static_cast<size_t>(width * height)) {
+        clear();
+        hasPrevious = false;
+        return false;
+    }
+
+    const Level& last = pyramids[currentIndex][0];
+    if (last.width != width || last.height != height) {
+        hasPrevious = false; // New geometry, nothing to track against
+        clear();
+    }
+    currentIndex ^= 1;
+    build(pyramids[currentIndex], luma, width, height);
+    if (!hasPrevious) {
+        hasPrevious = true;
+        return false;
+    }
+    if (!tracking) {
+        return false;
+    }
+
+    // Track every point, then keep the ones that agree with the median motion
+    moves.resize(points.size());
+    scratch.clear();
+    for (size_t i = 0; i < points.size(); ++i) {
+        if (track(points[i], moves[i])) {
+            scratch.push_back(moves[i].x);
+        } else {
+            moves[i] = glm::vec2(FLT_MAX);
+        }
+    }
+    if (static_cast<int>(scratch.size()) < minPoints) {
+        clear();
+        return false;
+    }
+    std::nth_element(scratch.begin(), scratch.begin() + scratch.size() / 2, scratch.end());
+    float medianX = scratch[scratch.size() / 2];
+    scratch.clear();
+    for (auto& move : moves) {
+        if (move.x != FLT_MAX) {
+            scratch.push_back(move.y);
+        }
+    }
+    std::nth_element(scratch.begin(), scratch.begin() + scratch.size() / 2, scratch.end());
+    glm::vec2 median(medianX, scratch[scratch.size() / 2]);
+
+    size_t kept = 0;
+    for (size_t i = 0; i < points.size(); ++i) {
+        if (moves[i].x != FLT_MAX && glm::distance(moves[i], median) < outlierDistance) {
+            points[kept++] = points[i] + moves[i];
+        }
+    }
+    points.resize(kept);
+    if (static_cast<int>(kept) < minPoints) {
+        clear();
+        return false;
+    }
+
+    displacement += median;
+    return true;
+}
+
+void FlowTracker::setAnchor(const ofRectangle& box) {
+    clear();
+    if (!hasPrevious) {
+        return;
+    }
+    const Level& level = pyramids[currentIndex][0];
+
+    // Score a regular grid of candidates inside the box, away from its edges and the image border
+    int margin = RADIUS + 1;
+    float x0 = std::max<float>(box.x + box.width * 0.1f, margin);
+    float y0 = std::max<float>(box.y + box.height * 0.1f, margin);
+    float x1 = std::min<float>(box.x + box.width * 0.9f, level.width - 1 - margin);
+    float y1 = std::min<float>(box.y + box.height * 0.9f, level.height - 1 - margin);
+    if (x1 <= x0 || y1 <= y0) {
+        return;
+    }
+    float spacing = std::max(2.f, std::sqrt((x1 - x0) * (y1 - y0) / (maxPoints * 4.f)));
+    candidates.clear();
+    scores.clear();
+    for (float y = y0; y <= y1; y += spacing) {
+        for (float x = x0; x <= x1; x += spacing) {
+            float score = cornerScore(level, x, y);
+            if (score >= minCornerScore) {
+                candidates.push_back(glm::vec2(x, y));
+                scores.push_back(score);
+            }
+        }
+    }
+
+    // Keep the strongest maxPoints
+    float cutoff = minCornerScore;
+    if (static_cast<int>(candidates.size()) > maxPoints) {
+        scratch = scores;
+        std::nth_element(scratch.begin(), scratch.begin() + maxPoints - 1, scratch.end(), std::greater<float>());
+        cutoff = scratch[maxPoints - 1];
+    }
+    for (size_t i = 0; i < candidates.size() && static_cast<int>(points.size()) < maxPoints; ++i) {
+        if (scores[i] >= cutoff) {
+            points.push_back(candidates[i]);
+        }
+    }
+    tracking = static_cast<int>(points.size()) >= minPoints;
+}
+
+void FlowTracker::clear() {
+    points.clear();
+    displacement = glm::vec2(0);
+    tracking = false;
+}
+
+void FlowTracker::build(Pyramid& pyramid, const std::vector<unsigned char>& luma, int width, int height) {
+    Level& base = pyramid[0];
+    base.width = width;
+    base.height = height;
+    base.data.resize(width * height);
+    std::copy(luma.begin(), luma.begin() + width * height, base.data.begin());
+
+    // Each level halves the one below with a 2x2 box filter
+    for (int l = 1; l < LEVELS; ++l) {
+        const Level& below = pyramid[l - 1];
+        Level& level = pyramid[l];
+        level.width = std::max(1, below.width / 2);
+        level.height = std::max(1, below.height / 2);
+        level.data.resize(level.width * level.height);
+        for (int y = 0; y < level.height; ++y) {
+            const float* row0 = below.data.data() + (y * 2) * below.width;
+            const float* row1 = row0 + (below.height > 1 ? below.width : 0);
+            float* out = level.data.data() + y * level.width;
+            for (int x = 0; x < level.width; ++x) {
+                out[x] = (row0[x * 2] + row0[x * 2 + 1] + row1[x * 2] + row1[x * 2 + 1]) * 0.25f;
+            }
+        }
+    }
+}
+
+// Smallest eigenvalue of the structure tensor around (x, y)
+float FlowTracker::cornerScore(const Level& level, float x, float y) const {
+    float gxx = 0, gxy = 0, gyy = 0;
+    for (int wy = -RADIUS; wy <= RADIUS; ++wy) {
+        for (int wx = -RADIUS; wx <= RADIUS; ++wx) {
+            float ix = (level.sample(x + wx + 1, y + wy) - level.sample(x + wx - 1, y + wy)) * 0.5f;
+            float iy = (level.sample(x + wx, y + wy + 1) - level.sample(x + wx, y + wy - 1)) * 0.5f;
+            gxx += ix * ix;
+            gxy += ix * iy;
+            gyy += iy * iy;
+        }
+    }
+    float trace = (gxx + gyy) * 0.5f;
+    return trace - std::sqrt((gxx - gyy) * (gxx - gyy) * 0.25f + gxy * gxy);
+}
+
+// Pyramidal Lucas-Kanade for one point from the previous to the current frame
+bool FlowTracker::track(const glm::vec2& point, glm::vec2& moved) const {
+    const Pyramid& previous = pyramids[currentIndex ^ 1];
+    const Pyramid& current = pyramids[currentIndex];
+    const int size = 2 * RADIUS + 1;
+    float templ[size * size], gradX[size * size], gradY[size * size];
+
+    glm::vec2 guess(0);
+    for (int l = LEVELS - 1; l >= 0; --l) {
+        const Level& prev = previous[l];
+        const Level& next = current[l];
+        float scale = 1.f / (1 << l);
+        glm::vec2 p = point * scale; // Windows reaching past the border sample clamped edge pixels
+
+        // Spatial gradient matrix of the window in the previous frame
+        float gxx = 0, gxy = 0, gyy = 0;
+        for (int wy = -RADIUS, i = 0; wy <= RADIUS; ++wy) {
+            for (int wx = -RADIUS; wx <= RADIUS; ++wx, ++i) {
+                float x = p.x + wx, y = p.y + wy;
+                templ[i] = prev.sample(x, y);
+                gradX[i] = (prev.sample(x + 1, y) - prev.sample(x - 1, y)) * 0.5f;
+                gradY[i] = (prev.sample(x, y + 1) - prev.sample(x, y - 1)) * 0.5f;
+                gxx += gradX[i] * gradX[i];
+                gxy += gradX[i] * gradY[i];
+                gyy += gradY[i] * gradY[i];
+            }
+        }
+        float det = gxx * gyy - gxy * gxy;
+        if (det < 1e-3f) {
+            return false;
+        }
+
+        // Iterate the residual motion at this level
+        glm::vec2 v(0);
+        for (int k = 0; k < ITERATIONS; ++k) {
+            float bx = 0, by = 0;
+            for (int wy = -RADIUS, i = 0; wy <= RADIUS; ++wy) {
+                for (int wx = -RADIUS; wx <= RADIUS; ++wx, ++i) {
+                    float diff = templ[i] - next.sample(p.x + guess.x + v.x + wx, p.y + guess.y + v.y + wy);
+                    bx += diff * gradX[i];
+                    by += diff * gradY[i];
+                }
+            }
+            glm::vec2 step((gyy * bx - gxy * by) / det, (gxx * by - gxy * bx) / det);
+            v += step;
+            if (std::abs(step.x) + std::abs(step.y) < 0.01f) {
+                break;
+            }
+        }
+        guess = l > 0 ? (guess + v) * 2.f : guess + v;
+    }
+
+    glm::vec2 target = point + guess;
+    const Level& base = current[0];
+    if (target.x < 0 || target.y < 0 || target.x > base.width - 1 || target.y > base.height - 1) {
+        return false;
+    }
+    moved = guess;
+    return true;
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "ofMain.h"
+
+// Sparse pyramidal Lucas-Kanade tracker used to follow the focus target between
+// detections. Works on a small grayscale image (the motion gate's luma grid),
+// picks corner-like points inside an anchor box and reports their median
+// displacement since the box was set. Buffers are only reallocated when the
+// image size changes.
+class FlowTracker {
+public:
+    // Feed the next grayscale frame, tracks the points from the previous one.
+    // Returns isTracking().
+    bool update(const std::vector<unsigned char>& luma, int width, int height);
+
+    // Pick new points inside box (image coordinates) on the last frame passed
+    // to update() and restart the displacement from zero
+    void setAnchor(const ofRectangle& box);
+
+    // Stop tracking until the next setAnchor()
+    void clear();
+
+    // Whether enough points survived to trust getDisplacement()
+    bool isTracking() const { return tracking; }
+
+    // Median point motion since setAnchor(), in image pixels
+    glm::vec2 getDisplacement() const { return displacement; }
+
+    const std::vector<glm::vec2>& getPoints() const { return points; }
+
+    void setMaxPoints(int count) { maxPoints = count; }
+    void setMinPoints(int count) { minPoints = count; }
+
+private:
+    static const int LEVELS = 3;
+    static const int RADIUS = 3;  // Window is (2 * RADIUS + 1)^2 samples
+    static const int ITERATIONS = 8;
+
+    struct Level {
+        std::vector<float> data;
+        int width = 0, height = 0;
+
+        float sample(float x, float y) const;
+    };
+    typedef Level Pyramid[LEVELS];
+
+    void build(Pyramid& pyramid, const std::vector<unsigned char>& luma, int width, int height);
+    bool track(const glm::vec2& point, glm::vec2& moved) const;
+    float cornerScore(const Level& level, float x, float y) const;
+
+    Pyramid pyramids[2];
+    int currentIndex = 0;
+    bool hasPrevious = false;
+
+    std::vector<glm::vec2> points;
+    std::vector<glm::vec2> moves;   // Scratch, per point motion this frame
+    std::vector<float> scratch;     // Scratch for medians and corner score selection
+    std::vector<glm::vec2> candidates;
+    std::vector<float> scores;      // Corner score of each candidate
+
+    int maxPoints = 32;
+    int minPoints = 4;
+    float minCornerScore = 100;     // Smallest structure tensor eigenvalue worth tracking
+    float outlierDistance = 1.5;    // Pixels from the median motion before a point is dropped
+
+    glm::vec2 displacement;
+    bool tracking = false;
+};
@@ -0,0 +1,81 @@
+#include "FramePool.h"
+
+FramePool::Ref::Ref(const Ref& other) : pool(other.pool), index(other.index) {
+    if (pool) {
+        pool->retain(index);
+    }
+}
+
+FramePool::Ref::Ref(Ref&& other) noexcept : pool(other.pool), index(other.index) {
+    other.pool = nullptr;
+    other.index = -1;
+}
+
+FramePool::Ref& FramePool::Ref::operator=(Ref other) noexcept {
+    std::swap(pool, other.pool);
+    std::swap(index, other.index);
+    return *this;
+}
+
+void FramePool::Ref::reset() {
+    if (pool) {
+        pool->release(index);
+        pool = nullptr;
+        index = -1;
+    }
+}
+
+Frame& FramePool::Ref::operator*() const {
+    return pool->slots[index].frame;
+}
+
+void FramePool::allocate(size_t count, size_t width, size_t height, ofPixelFormat format) {
+    slots.reset(new Slot[count]);
+    numFrames = count;
+    for (size_t i = 0; i < numFrames; ++i) {
+        slots[i].frame.pixels.allocate(width, height, format);
+    }
+}
+
+FramePool::Ref FramePool::acquire() {
+    for (size_t i = 0; i < numFrames; ++i) {
+        int expected = 0;
+        if (slots[i].refs.compare_exchange_strong(expected, 1, std::memory_order_acquire)) {
+            return Ref(this, static_cast<int>(i));
+        }
+    }
+    return Ref();
+}
+
+FramePool::Ref FramePool::copyFrom(const ofPixels& pixels) {
+    Ref frame = acquire();
+    if (!frame) {
+        return frame;
+    }
+    ofPixels& dst = frame->pixels;
+    if (dst.getTotalBytes() != pixels.getTotalBytes() || dst.getWidth() != pixels.getWidth()) {
+        ofLogWarning("FramePool") << "frame size " << pixels.getWidth() << "x" << pixels.getHeight() << " doesn't match pool";
+        return Ref();
+    }
+    memcpy(dst.getData(), pixels.getData(), pixels.getTotalBytes());
+    countCopy(pixels.getTotalBytes());
+    return frame;
+}
+
+size_t FramePool::getNumFramesInUse() const {
+    size_t inUse = 0;
+    for (size_t i = 0; i < numFrames; ++i) {
+        if (slots[i].refs.load(std::memory_order_relaxed) > 0) {
+            inUse++;
+        }
+    }
+    return inUse;
+}
+
+void FramePool::retain(int index) {
+    slots[index].refs.fetch_add(1, std::memory_order_relaxed);
+}
+
+void FramePool::release(int index) {
+    slots[index].refs.fetch_sub(1, std::memory_order_acq_rel);
+}
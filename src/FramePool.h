@@ -0,0 +1,72 @@
+#pragma once
+
+#include "ofMain.h"
+
+// A camera frame owned by a FramePool
+struct Frame {
+    ofPixels pixels;
+    uint64_t captureTime = 0; // ofGetElapsedTimeMicros() when the frame was captured
+    uint64_t id = 0;          // Capture order within its camera, for tracing a frame to its detection result
+};
+
+// Fixed-size pool of preallocated frames handed out as reference-counted handles,
+// so the display path and the detection worker share one capture buffer without
+// per-frame heap allocation. A frame returns to the pool when its last Ref goes away.
+class FramePool {
+public:
+    class Ref {
+    public:
+        Ref() : pool(nullptr), index(-1) {}
+        Ref(const Ref& other);
+        Ref(Ref&& other) noexcept;
+        Ref& operator=(Ref other) noexcept;
+        ~Ref() { reset(); }
+
+        void reset();
+
+        explicit operator bool() const { return pool != nullptr; }
+        Frame& operator*() const;
+        Frame* operator->() const { return &**this; }
+
+    private:
+        friend class FramePool;
+        Ref(FramePool* pool, int index) : pool(pool), index(index) {}
+
+        FramePool* pool;
+        int index;
+    };
+
+    FramePool() : numFrames(0) {}
+
+    // Allocate numFrames frames of the given size, must not be called while Refs are alive
+    void allocate(size_t numFrames, size_t width, size_t height, ofPixelFormat format);
+
+    // Claim a free frame, returns an empty Ref if every frame is in use
+    Ref acquire();
+
+    // Claim a free frame and copy pixels into it, returns an empty Ref if none is free
+    // or the pixels don't match the pool's frame size
+    Ref copyFrom(const ofPixels& pixels);
+
+    // Record bytes copied outside the pool so they show up in the per-frame counter
+    void countCopy(size_t bytes) { bytesCopied.fetch_add(bytes, std::memory_order_relaxed); }
+
+    // Bytes copied since the last call
+    uint64_t takeBytesCopied() { return bytesCopied.exchange(0, std::memory_order_relaxed); }
+
+    size_t getNumFrames() const { return numFrames; }
+    size_t getNumFramesInUse() const;
+
+private:
+    struct Slot {
+        Frame frame;
+        std::atomic<int> refs{0};
+    };
+
+    void retain(int index);
+    void release(int index);
+
+    std::unique_ptr<Slot[]> slots;
+    size_t numFrames;
+    std::atomic<uint64_t> bytesCopied{0};
+};
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "ofMain.h"
+
+// Where camera frames come from. ofApp only talks to this, so a recording or
+// another capture path can stand in for the webcam.
+class FrameSource {
+public:
+    virtual ~FrameSource() {}
+
+    // Start delivering frames, width, height and frameRate are what the source
+    // should aim for, sources that can't choose ignore them
+    virtual bool setup(int width, int height, float frameRate) = 0;
+
+    // Poll for a new frame, call once per app update
+    virtual void update() = 0;
+
+    virtual bool isFrameNew() const = 0;
+
+    // Newest frame, valid until the next update()
+    virtual const ofPixels& getPixels() const = 0;
+
+    virtual int getWidth() const = 0;
+    virtual int getHeight() const = 0;
+
+    virtual bool isInitialized() const = 0;
+    virtual void close() = 0;
+};
+
+// Live camera through ofVideoGrabber, CPU pixels only
+class GrabberSource : public FrameSource {
+public:
+    explicit GrabberSource(int deviceId = 0) : deviceId(deviceId) {}
+
+    bool setup(int width, int height, float frameRate) override {
+        grabber.setUseTexture(false); // Frames are uploaded to displayTexture instead
+        grabber.setDeviceID(deviceId);
+        grabber.setDesiredFrameRate(frameRate);
+        if (!grabber.setup(width, height)) {
+            return false;
+        }
+        grabber.update();
+        return true;
+    }
+
+    void update() override { grabber.update(); }
+    bool isFrameNew() const override { return grabber.isFrameNew(); }
+    const ofPixels& getPixels() const override { return grabber.getPixels(); }
+    int getWidth() const override { return grabber.getWidth(); }
+    int getHeight() const override { return grabber.getHeight(); }
+    bool isInitialized() const override { return grabber.isInitialized(); }
+    void close() override { grabber.close(); }
+
+private:
+    ofVideoGrabber grabber;
+    int deviceId;
+};
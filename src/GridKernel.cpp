@@ -0,0 +1,154 @@
+#include "GridKernel.h"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define GRID_KERNEL_SSE2
+#include <emmintrin.h>
+#if defined(__GNUC__)
+#define GRID_KERNEL_AVX2
+#include <immintrin.h>
+#endif
+#elif defined(__ARM_NEON)
+#define GRID_KERNEL_NEON
+#include <arm_neon.h>
+#endif
+
+// Every path evaluates:
+//   width = rampy * zoomWidth
+//   x = centerX + rampy * (width * (focus.x - 1) + offsetX), clamped to [0, imageWidth - width]
+// and the same for y and height.
+
+namespace {
+    inline void computeCell(size_t i, const GridKernel::Cells& cells, float rampy, float focusX, float focusY,
+                            float imageWidth, float imageHeight, const GridKernel::SourceRects& out) {
+        float width = rampy * cells.zoomWidth[i];
+        float height = rampy * cells.zoomHeight[i];
+        float x = cells.centerX[i] + rampy * (width * focusX + cells.offsetX[i]);
+        float y = cells.centerY[i] + rampy * (height * focusY + cells.offsetY[i]);
+        out.x[i] = std::max(std::min(x, imageWidth - width), 0.f);
+        out.y[i] = std::max(std::min(y, imageHeight - height), 0.f);
+        out.width[i] = width;
+        out.height[i] = height;
+    }
+
+    void computeRange(size_t begin, size_t end, const GridKernel::Cells& cells, const GridKernel::Params& params,
+                      const GridKernel::SourceRects& out) {
+        const float focusX = params.focus.x - 1;
+        const float focusY = params.focus.y - 1;
+        for (size_t i = begin; i < end; ++i) {
+            computeCell(i, cells, params.rampy, focusX, focusY, params.imageWidth, params.imageHeight, out);
+        }
+    }
+
+#ifdef GRID_KERNEL_SSE2
+    void computeSse2(size_t begin, size_t n, const GridKernel::Cells& cells, const GridKernel::Params& params, const GridKernel::SourceRects& out) {
+        const __m128 rampy = _mm_set1_ps(params.rampy);
+        const __m128 focusX = _mm_set1_ps(params.focus.x - 1);
+        const __m128 focusY = _mm_set1_ps(params.focus.y - 1);
+        const __m128 imageWidth = _mm_set1_ps(params.imageWidth);
+        const __m128 imageHeight = _mm_set1_ps(params.imageHeight);
+        const __m128 zero = _mm_setzero_ps();
+        size_t i = begin;
+        for (; i + 4 <= n; i += 4) {
+            __m128 width = _mm_mul_ps(rampy, _mm_loadu_ps(cells.zoomWidth + i));
+            __m128 height = _mm_mul_ps(rampy, _mm_loadu_ps(cells.zoomHeight + i));
+            __m128 x = _mm_add_ps(_mm_loadu_ps(cells.centerX + i), _mm_mul_ps(rampy, _mm_add_ps(_mm_mul_ps(width, focusX), _mm_loadu_ps(cells.offsetX + i))));
+            __m128 y = _mm_add_ps(_mm_loadu_ps(cells.centerY + i), _mm_mul_ps(rampy, _mm_add_ps(_mm_mul_ps(height, focusY), _mm_loadu_ps(cells.offsetY + i))));
+            _mm_storeu_ps(out.x + i, _mm_max_ps(_mm_min_ps(x, _mm_sub_ps(imageWidth, width)), zero));
+            _mm_storeu_ps(out.y + i, _mm_max_ps(_mm_min_ps(y, _mm_sub_ps(imageHeight, height)), zero));
+            _mm_storeu_ps(out.width + i, width);
+            _mm_storeu_ps(out.height + i, height);
+        }
+        computeRange(i, n, cells, params, out);
+    }
+#endif
+
+#ifdef GRID_KERNEL_AVX2
+    __attribute__((target("avx2")))
+    void computeAvx2(size_t n, const GridKernel::Cells& cells, const GridKernel::Params& params, const GridKernel::SourceRects& out) {
+        const __m256 rampy = _mm256_set1_ps(params.rampy);
+        const __m256 focusX = _mm256_set1_ps(params.focus.x - 1);
+        const __m256 focusY = _mm256_set1_ps(params.focus.y - 1);
+        const __m256 imageWidth = _mm256_set1_ps(params.imageWidth);
+        const __m256 imageHeight = _mm256_set1_ps(params.imageHeight);
+        const __m256 zero = _mm256_setzero_ps();
+        size_t i = 0;
+        for (; i + 8 <= n; i += 8) {
+            __m256 width = _mm256_mul_ps(rampy, _mm256_loadu_ps(cells.zoomWidth + i));
+            __m256 height = _mm256_mul_ps(rampy, _mm256_loadu_ps(cells.zoomHeight + i));
+            __m256 x = _mm256_add_ps(_mm256_loadu_ps(cells.centerX + i), _mm256_mul_ps(rampy, _mm256_add_ps(_mm256_mul_ps(width, focusX), _mm256_loadu_ps(cells.offsetX + i))));
+            __m256 y = _mm256_add_ps(_mm256_loadu_ps(cells.centerY + i), _mm256_mul_ps(rampy, _mm256_add_ps(_mm256_mul_ps(height, focusY), _mm256_loadu_ps(cells.offsetY + i))));
+            _mm256_storeu_ps(out.x + i, _mm256_max_ps(_mm256_min_ps(x, _mm256_sub_ps(imageWidth, width)), zero));
+            _mm256_storeu_ps(out.y + i, _mm256_max_ps(_mm256_min_ps(y, _mm256_sub_ps(imageHeight, height)), zero));
+            _mm256_storeu_ps(out.width + i, width);
+            _mm256_storeu_ps(out.height + i, height);
+        }
+
+        // Clear the upper halves before running SSE code, or every SSE instruction pays for the mixed state
+        _mm256_zeroupper();
+        computeSse2(i, n, cells, params, out);
+    }
+
+    bool hasAvx2() {
+        static const bool supported = __builtin_cpu_supports("avx2");
+        return supported;
+    }
+#endif
+
+#ifdef GRID_KERNEL_NEON
+    void computeNeon(size_t n, const GridKernel::Cells& cells, const GridKernel::Params& params, const GridKernel::SourceRects& out) {
+        const float32x4_t rampy = vdupq_n_f32(params.rampy);
+        const float32x4_t focusX = vdupq_n_f32(params.focus.x - 1);
+        const float32x4_t focusY = vdupq_n_f32(params.focus.y - 1);
+        const float32x4_t imageWidth = vdupq_n_f32(params.imageWidth);
+        const float32x4_t imageHeight = vdupq_n_f32(params.imageHeight);
+        const float32x4_t zero = vdupq_n_f32(0);
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            float32x4_t width = vmulq_f32(rampy, vld1q_f32(cells.zoomWidth + i));
+            float32x4_t height = vmulq_f32(rampy, vld1q_f32(cells.zoomHeight + i));
+            float32x4_t x = vaddq_f32(vld1q_f32(cells.centerX + i), vmulq_f32(rampy, vaddq_f32(vmulq_f32(width, focusX), vld1q_f32(cells.offsetX + i))));
+            float32x4_t y = vaddq_f32(vld1q_f32(cells.centerY + i), vmulq_f32(rampy, vaddq_f32(vmulq_f32(height, focusY), vld1q_f32(cells.offsetY + i))));
+            vst1q_f32(out.x + i, vmaxq_f32(vminq_f32(x, vsubq_f32(imageWidth, width)), zero));
+            vst1q_f32(out.y + i, vmaxq_f32(vminq_f32(y, vsubq_f32(imageHeight, height)), zero));
+            vst1q_f32(out.width + i, width);
+            vst1q_f32(out.height + i, height);
+        }
+        computeRange(i, n, cells, params, out);
+    }
+#endif
+}
+
+void GridKernel::computeSourceRects(size_t n, const Cells& cells, const Params& params, const SourceRects& out) {
+#if defined(GRID_KERNEL_AVX2)
+    if (hasAvx2()) {
+        computeAvx2(n, cells, params, out);
+        return;
+    }
+#endif
+#if defined(GRID_KERNEL_SSE2)
+    computeSse2(0, n, cells, params, out);
+#elif defined(GRID_KERNEL_NEON)
+    computeNeon(n, cells, params, out);
+#else
+    computeRange(0, n, cells, params, out);
+#endif
+}
+
+void GridKernel::computeSourceRectsScalar(size_t n, const Cells& cells, const Params& params, const SourceRects& out) {
+    computeRange(0, n, cells, params, out);
+}
+
+const char* GridKernel::getInstructionSet() {
+#if defined(GRID_KERNEL_AVX2)
+    if (hasAvx2()) {
+        return "avx2";
+    }
+#endif
+#if defined(GRID_KERNEL_SSE2)
+    return "sse2";
+#elif defined(GRID_KERNEL_NEON)
+    return "neon";
+#else
+    return "scalar";
+#endif
+}
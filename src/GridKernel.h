@@ -0,0 +1,43 @@
+#pragma once
+
+#include "ofMain.h"
+
+// Per-frame source rect math of the zoom grid, run over all cells at once.
+// GridLayout keeps the per-cell inputs as parallel arrays, so the kernel
+// processes 4 (SSE2, NEON) or 8 (AVX2) cells per instruction. AVX2 is
+// picked at runtime, SSE2 and NEON are always there on x86-64 and arm64, and
+// other targets use the scalar loop. All paths agree up to float rounding.
+namespace GridKernel {
+    // Per-cell inputs, see GridLayout
+    struct Cells {
+        const float* zoomWidth;  // Source size at rampy 1
+        const float* zoomHeight;
+        const float* centerX;    // Source position at rampy 0
+        const float* centerY;
+        const float* offsetX;    // Offset in source pixels at rampy 1
+        const float* offsetY;
+    };
+
+    // Per-cell outputs in source pixels
+    struct SourceRects {
+        float* x;
+        float* y;
+        float* width;
+        float* height;
+    };
+
+    struct Params {
+        float rampy = 0;          // Transition progress 0-1
+        glm::vec2 focus;          // Normalized focus point
+        float imageWidth = 0, imageHeight = 0;
+    };
+
+    // Source rects of n cells with the fastest instruction set available
+    void computeSourceRects(size_t n, const Cells& cells, const Params& params, const SourceRects& out);
+
+    // One cell at a time, the reference for the vector paths
+    void computeSourceRectsScalar(size_t n, const Cells& cells, const Params& params, const SourceRects& out);
+
+    // Instruction set computeSourceRects() uses, ie. "avx2"
+    const char* getInstructionSet();
+}
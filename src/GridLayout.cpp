@@ -0,0 +1,154 @@
+#include "GridLayout.h"
+
+void GridLayout::setGrid(int numRows, int numCols, float width, float height) {
+    rows = ofClamp(numRows, 1, MAX_ROWS);
+    cols = ofClamp(numCols, 1, MAX_COLS);
+    cellWidth = width;
+    cellHeight = height;
+
+    // Storage for the largest grid so far stays allocated
+    size_t positions = static_cast<size_t>(rows) * cols;
+    for (auto* cells : {&cellRow, &cellCol}) {
+        cells->reserve(positions);
+    }
+    for (auto* cells : {&offsetFactorX, &offsetFactorY, &screenX, &screenY, &screenWidth, &screenHeight,
+                        &zoomWidth, &zoomHeight, &centerX, &centerY, &offsetX, &offsetY,
+                        &sourceX, &sourceY, &sourceWidth, &sourceHeight}) {
+        cells->reserve(positions);
+    }
+    reset();
+}
+
+void GridLayout::setImage(int width, int height, float scale) {
+    if (width != imageWidth || height != imageHeight || scale != scaleFactor) {
+        imageWidth = width;
+        imageHeight = height;
+        scaleFactor = scale;
+        geometryChanged = true;
+    }
+}
+
+void GridLayout::merge(int row, int col, int rowSpan, int colSpan) {
+    if (row < 0 || col < 0 || row >= rows || col >= cols || rowSpan < 1 || colSpan < 1) {
+        return;
+    }
+    for (int r = row; r < std::min(row + rowSpan, rows); ++r) {
+        for (int c = col; c < std::min(col + colSpan, cols); ++c) {
+            rowSpans[r * cols + c] = 0;
+            colSpans[r * cols + c] = 0;
+        }
+    }
+    rowSpans[row * cols + col] = std::min(rowSpan, 255);
+    colSpans[row * cols + col] = std::min(colSpan, 255);
+    cellsChanged = true;
+}
+
+void GridLayout::reset() {
+    rowSpans.assign(static_cast<size_t>(rows) * cols, 1);
+    colSpans.assign(static_cast<size_t>(rows) * cols, 1);
+    cellsChanged = true;
+}
+
+void GridLayout::randomizeOffsets(float maxX, float maxY) {
+    updateCells();
+
+    // Cells are in row-major order, so the next visible cell is the only one that can be at this position
+    size_t cell = 0;
+    for (int row = 0; row < rows; ++row) {
+        for (int col = 0; col < cols; ++col) {
+            float x = ofRandom(-maxX, maxX);
+            float y = ofRandom(-maxY, maxY);
+            if (cell < cellRow.size() && cellRow[cell] == row && cellCol[cell] == col) {
+                offsetFactorX[cell] = x;
+                offsetFactorY[cell] = y;
+                cell++;
+            }
+        }
+    }
+    geometryChanged = true;
+}
+
+void GridLayout::build(float rampy, const glm::vec2& focus, GridRenderer& renderer) {
+    update(rampy, focus);
+    renderer.addCells(cellRow.size(), screenX.data(), screenY.data(), screenWidth.data(), screenHeight.data(),
+                      sourceX.data(), sourceY.data(), sourceWidth.data(), sourceHeight.data());
+}
+
+void GridLayout::update(float rampy, const glm::vec2& focus) {
+    updateCells();
+    updateGeometry();
+
+    // Zoomed source size grows with rampy, its position moves from the cell's
+    // center toward the focus point plus offset, which also scales with rampy
+    GridKernel::Params params;
+    params.rampy = rampy;
+    params.focus = focus;
+    params.imageWidth = imageWidth;
+    params.imageHeight = imageHeight;
+    size_t n = cellRow.size();
+    GridKernel::computeSourceRects(n, {zoomWidth.data(), zoomHeight.data(), centerX.data(), centerY.data(), offsetX.data(), offsetY.data()},
+                                   params, {sourceX.data(), sourceY.data(), sourceWidth.data(), sourceHeight.data()});
+}
+
+void GridLayout::addCells(GridRenderer& renderer, const ofRectangle& area) const {
+    for (size_t i = 0, n = cellRow.size(); i < n; ++i) {
+        if (screenX[i] < area.getRight() && screenX[i] + screenWidth[i] > area.x &&
+            screenY[i] < area.getBottom() && screenY[i] + screenHeight[i] > area.y) {
+            renderer.addCell(screenX[i], screenY[i], screenWidth[i], screenHeight[i], sourceX[i], sourceY[i], sourceWidth[i], sourceHeight[i]);
+        }
+    }
+}
+
+void GridLayout::updateCells() {
+    if (!cellsChanged) {
+        return;
+    }
+    cellRow.clear();
+    cellCol.clear();
+    for (int row = 0; row < rows; ++row) {
+        for (int col = 0; col < cols; ++col) {
+            if (rowSpans[row * cols + col] > 0) {
+                cellRow.push_back(row);
+                cellCol.push_back(col);
+            }
+        }
+    }
+    size_t n = cellRow.size();
+    offsetFactorX.assign(n, 0);
+    offsetFactorY.assign(n, 0);
+    for (auto* cells : {&screenX, &screenY, &screenWidth, &screenHeight, &zoomWidth, &zoomHeight, &centerX, &centerY, &offsetX, &offsetY,
+                        &sourceX, &sourceY, &sourceWidth, &sourceHeight}) {
+        cells->resize(n);
+    }
+    cellsChanged = false;
+    geometryChanged = true;
+}
+
+void GridLayout::updateGeometry() {
+    if (!geometryChanged) {
+        return;
+    }
+    for (size_t i = 0, n = cellRow.size(); i < n; ++i) {
+        int position = cellRow[i] * cols + cellCol[i];
+        screenX[i] = cellWidth * cellCol[i];
+        screenY[i] = cellHeight * cellRow[i];
+        screenWidth[i] = cellWidth * colSpans[position];
+        screenHeight[i] = cellHeight * rowSpans[position];
+
+        // The zoomed source keeps the cell's aspect ratio, its longer side spans 1 / zoomFactor of the image
+        float aspectRatio = screenWidth[i] / screenHeight[i];
+        if (aspectRatio >= 1) {
+            zoomWidth[i] = imageWidth * scaleFactor;
+            zoomHeight[i] = zoomWidth[i] / aspectRatio;
+        } else {
+            zoomHeight[i] = imageHeight * scaleFactor;
+            zoomWidth[i] = zoomHeight[i] * aspectRatio;
+        }
+
+        centerX[i] = screenX[i] + cellWidth * 0.5f;
+        centerY[i] = screenY[i] + cellHeight * 0.5f;
+        offsetX[i] = imageWidth * offsetFactorX[i];
+        offsetY[i] = imageHeight * offsetFactorY[i];
+    }
+    geometryChanged = false;
+}
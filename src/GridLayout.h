@@ -0,0 +1,76 @@
+#pragma once
+
+#include "ofMain.h"
+#include "GridRenderer.h"
+#include "GridKernel.h"
+
+// Cells of the zoom grid: where each visible cell sits on screen and which
+// part of the camera image it shows around the focus point. Shared by ofApp
+// and the benchmark so both run the same math.
+//
+// Only visible cells are stored, as parallel arrays in row-major order. Their
+// rects, zoom sizes and offsets are cached whenever the grid, a merge, the
+// offsets or the image settings change, so build() only does the part that
+// follows rampy and the focus point, in GridKernel's vector loop.
+class GridLayout {
+public:
+    static const int MAX_ROWS = 256;
+    static const int MAX_COLS = 256;
+
+    // Start over with rows x cols unmerged cells of cellWidth x cellHeight and no offsets
+    void setGrid(int rows, int cols, float cellWidth, float cellHeight);
+
+    // Source image size and 1 / zoomFactor, cheap to call every frame when unchanged
+    void setImage(int imageWidth, int imageHeight, float scaleFactor);
+
+    // Merge rowSpan x colSpan cells into the cell at row, col. Cells it covers
+    // disappear, even if they were merged themselves. A merged cell may reach
+    // past the grid's edge, merging clears the offsets.
+    void merge(int row, int col, int rowSpan, int colSpan);
+
+    // Undo all merges and offsets
+    void reset();
+
+    // Random offset per cell within +-maxX, +-maxY as a fraction of the image
+    // size. Draws two ofRandom() values for every grid position, merged or not.
+    void randomizeOffsets(float maxX, float maxY);
+
+    // Queue every visible cell on renderer for transition progress rampy (0-1)
+    // and the normalized focus point, update() and addCells() in one
+    void build(float rampy, const glm::vec2& focus, GridRenderer& renderer);
+
+    // Compute this frame's source rects for transition progress rampy (0-1)
+    // and the normalized focus point
+    void update(float rampy, const glm::vec2& focus);
+
+    // Queue the cells of the last update() that overlap area, in screen pixels,
+    // so each output of a video wall only draws its own cells
+    void addCells(GridRenderer& renderer, const ofRectangle& area) const;
+
+    int getRows() const { return rows; }
+    int getCols() const { return cols; }
+    size_t getNumCells() const { return cellRow.size(); }
+
+private:
+    void updateCells();
+    void updateGeometry();
+
+    int rows = 0, cols = 0;
+    float cellWidth = 0, cellHeight = 0;
+    int imageWidth = 0, imageHeight = 0;
+    float scaleFactor = 1;
+
+    // Span of the cell at each grid position, 0 where a merge covers it
+    vector<uint8_t> rowSpans, colSpans;
+    bool cellsChanged = true;
+    bool geometryChanged = true;
+
+    // Visible cells
+    vector<uint16_t> cellRow, cellCol;
+    vector<float> offsetFactorX, offsetFactorY;  // Fraction of the image size
+    vector<float> screenX, screenY, screenWidth, screenHeight;
+    vector<float> zoomWidth, zoomHeight;          // Source size at rampy 1
+    vector<float> centerX, centerY;               // Source position at rampy 0, the cell's own center
+    vector<float> offsetX, offsetY;               // Offsets in source pixels
+    vector<float> sourceX, sourceY, sourceWidth, sourceHeight; // This frame's source rects
+};
@@ -0,0 +1,124 @@
+#include "GridRenderer.h"
+
+GridRenderer::GridRenderer() : numCells(0), sourceWidth(0), sourceHeight(0) {
+    cellMesh.setMode(OF_PRIMITIVE_TRIANGLES);
+    cellMesh.setUsage(GL_STREAM_DRAW);
+    outlineMesh.setMode(OF_PRIMITIVE_LINES);
+    outlineMesh.setUsage(GL_STREAM_DRAW);
+}
+
+void GridRenderer::setSourceSize(float width, float height) {
+    sourceWidth = width;
+    sourceHeight = height;
+}
+
+void GridRenderer::clear() {
+    // std::vector::clear keeps capacity, so steady state frames don't allocate
+    cellMesh.getVertices().clear();
+    cellMesh.getTexCoords().clear();
+    cellMesh.getIndices().clear();
+    numCells = 0;
+}
+
+void GridRenderer::addCell(float x, float y, float w, float h, float sx, float sy, float sw, float sh) {
+    auto& vertices = cellMesh.getVertices();
+    auto& texCoords = cellMesh.getTexCoords();
+    auto& indices = cellMesh.getIndices();
+
+    ofIndexType first = static_cast<ofIndexType>(vertices.size());
+
+    vertices.emplace_back(x, y, 0);
+    vertices.emplace_back(x + w, y, 0);
+    vertices.emplace_back(x + w, y + h, 0);
+    vertices.emplace_back(x, y + h, 0);
+
+    // Texture pixel coordinates, converted to the texture's own space in draw()
+    texCoords.emplace_back(sx, sy);
+    texCoords.emplace_back(sx + sw, sy);
+    texCoords.emplace_back(sx + sw, sy + sh);
+    texCoords.emplace_back(sx, sy + sh);
+
+    indices.push_back(first);
+    indices.push_back(first + 1);
+    indices.push_back(first + 2);
+    indices.push_back(first);
+    indices.push_back(first + 2);
+    indices.push_back(first + 3);
+
+    numCells++;
+}
+
+void GridRenderer::addCells(size_t n, const float* x, const float* y, const float* w, const float* h,
+                            const float* sx, const float* sy, const float* sw, const float* sh) {
+    auto& vertices = cellMesh.getVertices();
+    auto& texCoords = cellMesh.getTexCoords();
+    auto& indices = cellMesh.getIndices();
+
+    // Grow once, then write in place
+    size_t firstVertex = vertices.size();
+    size_t firstIndex = indices.size();
+    vertices.resize(firstVertex + n * 4);
+    texCoords.resize(firstVertex + n * 4);
+    indices.resize(firstIndex + n * 6);
+
+    glm::vec3* vertex = vertices.data() + firstVertex;
+    glm::vec2* texCoord = texCoords.data() + firstVertex;
+    ofIndexType* index = indices.data() + firstIndex;
+    for (size_t i = 0; i < n; ++i, vertex += 4, texCoord += 4, index += 6) {
+        vertex[0] = glm::vec3(x[i], y[i], 0);
+        vertex[1] = glm::vec3(x[i] + w[i], y[i], 0);
+        vertex[2] = glm::vec3(x[i] + w[i], y[i] + h[i], 0);
+        vertex[3] = glm::vec3(x[i], y[i] + h[i], 0);
+
+        texCoord[0] = glm::vec2(sx[i], sy[i]);
+        texCoord[1] = glm::vec2(sx[i] + sw[i], sy[i]);
+        texCoord[2] = glm::vec2(sx[i] + sw[i], sy[i] + sh[i]);
+        texCoord[3] = glm::vec2(sx[i], sy[i] + sh[i]);
+
+        ofIndexType first = static_cast<ofIndexType>(firstVertex + i * 4);
+        index[0] = first;
+        index[1] = first + 1;
+        index[2] = first + 2;
+        index[3] = first;
+        index[4] = first + 2;
+        index[5] = first + 3;
+    }
+
+    numCells += n;
+}
+
+void GridRenderer::draw(const ofTexture& texture, const ofColor& outlineColor, float lineWidth) {
+    if (numCells == 0 || !texture.isAllocated()) {
+        return;
+    }
+
+    // Map source coordinates into the texture's coordinate space (ARB rectangle or normalized, possibly flipped)
+    glm::vec2 sourceSize(sourceWidth > 0 ? sourceWidth : texture.getWidth(), sourceHeight > 0 ? sourceHeight : texture.getHeight());
+    glm::vec2 origin = texture.getCoordFromPoint(0, 0);
+    glm::vec2 scale = (texture.getCoordFromPoint(texture.getWidth(), texture.getHeight()) - origin) / sourceSize;
+    for (auto& texCoord : cellMesh.getTexCoords()) {
+        texCoord = origin + texCoord * scale;
+    }
+
+    texture.bind();
+    cellMesh.draw();
+    texture.unbind();
+
+    if (lineWidth > 0) {
+        auto& outlineVertices = outlineMesh.getVertices();
+        auto& outlineIndices = outlineMesh.getIndices();
+        outlineVertices = cellMesh.getVertices();
+        outlineIndices.clear();
+        for (ofIndexType first = 0; first < outlineVertices.size(); first += 4) {
+            for (ofIndexType corner = 0; corner < 4; ++corner) {
+                outlineIndices.push_back(first + corner);
+                outlineIndices.push_back(first + (corner + 1) % 4);
+            }
+        }
+
+        ofSetColor(outlineColor);
+        ofSetLineWidth(lineWidth);
+        outlineMesh.draw();
+        ofSetColor(255, 255, 255);
+    }
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "ofMain.h"
+
+// Batches every visible grid cell into one textured mesh plus one outline mesh,
+// so a full grid costs two draw calls instead of a drawSubsection per cell
+class GridRenderer {
+public:
+    GridRenderer();
+
+    // Size of the space addCell's source rects are given in, mapped onto the whole texture
+    // at draw time. Defaults to the texture's own pixel size.
+    void setSourceSize(float width, float height);
+
+    // Drop the cells queued for the last frame, keeping the allocated storage
+    void clear();
+
+    // Queue a cell: x, y, w, h on screen, sx, sy, sw, sh in source pixels
+    void addCell(float x, float y, float w, float h, float sx, float sy, float sw, float sh);
+
+    // Queue n cells at once from parallel arrays, same parameters as addCell
+    void addCells(size_t n, const float* x, const float* y, const float* w, const float* h,
+                  const float* sx, const float* sy, const float* sw, const float* sh);
+
+    // Draw the queued cells sampled from texture, then their outlines if lineWidth > 0
+    void draw(const ofTexture& texture, const ofColor& outlineColor, float lineWidth);
+
+    size_t getNumCells() const { return numCells; }
+
+private:
+    ofVboMesh cellMesh;
+    ofVboMesh outlineMesh;
+    size_t numCells;
+    float sourceWidth, sourceHeight;
+};
@@ -0,0 +1,253 @@
+#include "HeadlessOutput.h"
+#include "Profiler.h"
+
+namespace {
+    const char* USAGE =
+        "usage: Blow_Up_3_0_2 [--headless [options]]\n"
+        "  --headless         render offscreen instead of to a fullscreen window\n"
+        "  --size WxH         output resolution (default 1920x1080)\n"
+        "  --fps F            output frame rate (default 30)\n"
+        "  --frames N         frames to render before exiting (default: until closed)\n"
+        "  --out PATH         .y4m for I420 Y4M, anything else for raw RGB24 (default: discard)\n"
+        "  --times PATH       per frame draw, readback and write times as CSV\n"
+        "  --fixed-step       advance app time by exactly 1/fps per frame\n";
+
+    float mean(const vector<float>& samples) {
+        return samples.empty() ? 0 : std::accumulate(samples.begin(), samples.end(), 0.f) / samples.size();
+    }
+
+    float percentile(vector<float> samples, float p) {
+        if (samples.empty()) {
+            return 0;
+        }
+        size_t rank = std::min(samples.size() - 1, static_cast<size_t>(p * samples.size()));
+        std::nth_element(samples.begin(), samples.begin() + rank, samples.end());
+        return samples[rank];
+    }
+
+    // BT.601 limited range, like most Y4M consumers assume
+    inline unsigned char lumaOf(int r, int g, int b) {
+        return ((66 * r + 129 * g + 25 * b + 128) >> 8) + 16;
+    }
+}
+
+bool HeadlessOutput::parseArguments(int argc, char* argv[], Settings& settings) {
+    bool options = false;
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--help") {
+            std::cerr << USAGE;
+            return false;
+        } else if (arg == "--headless") {
+            settings.enabled = true;
+            continue;
+        } else if (arg == "--fixed-step") {
+            settings.fixedStep = true;
+        } else if (arg.rfind("--", 0) == 0 && !hasValue) {
+            std::cerr << "missing value for " << arg << "\n" << USAGE;
+            return false;
+        } else if (arg == "--size") {
+            vector<string> values = ofSplitString(argv[++i], "x");
+            if (values.size() != 2 || ofToInt(values[0]) < 2 || ofToInt(values[1]) < 2) {
+                std::cerr << "--size needs WxH\n" << USAGE;
+                return false;
+            }
+            settings.width = ofToInt(values[0]);
+            settings.height = ofToInt(values[1]);
+        } else if (arg == "--fps") {
+            settings.frameRate = std::max(1.f, ofToFloat(argv[++i]));
+        } else if (arg == "--frames") {
+            settings.frames = ofToInt64(argv[++i]);
+        } else if (arg == "--out") {
+            settings.output = argv[++i];
+        } else if (arg == "--times") {
+            settings.times = argv[++i];
+        } else {
+            std::cerr << "unknown option " << arg << "\n" << USAGE;
+            return false;
+        }
+        options = true;
+    }
+    if (options && !settings.enabled) {
+        std::cerr << "options need --headless\n" << USAGE;
+        return false;
+    }
+    return true;
+}
+
+HeadlessOutput::~HeadlessOutput() {
+    close();
+}
+
+bool HeadlessOutput::setup(const Settings& headlessSettings) {
+    settings = headlessSettings;
+
+    fbo.allocate(settings.width, settings.height, GL_RGBA);
+    size_t bytes = static_cast<size_t>(settings.width) * settings.height * 4;
+    for (auto& pbo : pbos) {
+        pbo.allocate(bytes, GL_STREAM_READ);
+    }
+
+    if (settings.output.empty()) {
+        format = DISCARD;
+    } else {
+        format = ofToLower(ofFilePath::getFileExt(settings.output)) == "y4m" ? Y4M : RAW;
+        file = fopen(ofToDataPath(settings.output).c_str(), "wb");
+        if (!file) {
+            ofLogError("HeadlessOutput") << "Can't open " << settings.output;
+            return false;
+        }
+        if (format == Y4M) {
+            // C420jpeg: chroma sited between the 2x2 luma samples it averages
+            fprintf(file, "YUV4MPEG2 W%d H%d F%d:1000 Ip A1:1 C420jpeg\n", settings.width, settings.height,
+                    static_cast<int>(std::round(settings.frameRate * 1000)));
+            int chromaWidth = (settings.width + 1) / 2, chromaHeight = (settings.height + 1) / 2;
+            converted.resize(static_cast<size_t>(settings.width) * settings.height + 2 * chromaWidth * chromaHeight);
+        } else {
+            converted.resize(static_cast<size_t>(settings.width) * settings.height * 3);
+        }
+    }
+
+    if (!settings.times.empty()) {
+        timesFile = fopen(ofToDataPath(settings.times).c_str(), "w");
+        if (!timesFile) {
+            ofLogError("HeadlessOutput") << "Can't open " << settings.times;
+            return false;
+        }
+        fprintf(timesFile, "frame,drawMs,copyMs,mapMs,writeMs\n");
+    }
+
+    rendered = 0;
+    runStart = Profiler::now();
+    ofLogNotice("HeadlessOutput") << "Rendering " << settings.width << "x" << settings.height << " at " << settings.frameRate
+                                  << " fps to " << (settings.output.empty() ? "nowhere" : settings.output);
+    return true;
+}
+
+void HeadlessOutput::begin() {
+    drawStart = Profiler::now();
+    fbo.begin();
+    ofClear(0, 0, 0, 255);
+}
+
+void HeadlessOutput::end() {
+    fbo.end();
+    uint64_t copyStart = Profiler::now();
+    int current = rendered % 2;
+
+    // Start this frame's readback into its PBO, glReadPixels returns without waiting for the GPU
+    FrameTimes& times = pendingTimes[current];
+    times.frame = rendered;
+    times.drawMs = (copyStart - drawStart) * 0.001f;
+    fbo.copyTo(pbos[current]);
+    times.copyMs = (Profiler::now() - copyStart) * 0.001f;
+    pending[current] = true;
+    rendered++;
+
+    // The previous frame had a whole frame to finish, mapping it rarely stalls
+    flush(1 - current);
+}
+
+void HeadlessOutput::close() {
+    if (rendered == 0 && !file && !timesFile) {
+        return;
+    }
+    // Only the last frame is still in flight
+    flush(0);
+    flush(1);
+
+    double seconds = (Profiler::now() - runStart) * 1e-6;
+    if (rendered > 0) {
+        ofLogNotice("HeadlessOutput") << rendered << " frames in " << ofToString(seconds, 2) << " s, " << ofToString(rendered / seconds, 1) << " fps";
+        ofLogNotice("HeadlessOutput") << "draw mean " << ofToString(mean(drawSamples), 2) << " p95 " << ofToString(percentile(drawSamples, 0.95), 2)
+                                      << " ms, readback mean " << ofToString(mean(readbackSamples), 2) << " p95 " << ofToString(percentile(readbackSamples, 0.95), 2)
+                                      << " ms, write mean " << ofToString(mean(writeSamples), 2) << " p95 " << ofToString(percentile(writeSamples, 0.95), 2) << " ms";
+    }
+
+    if (file) {
+        fclose(file);
+        file = nullptr;
+    }
+    if (timesFile) {
+        fclose(timesFile);
+        timesFile = nullptr;
+    }
+    rendered = 0;
+    drawSamples.clear();
+    readbackSamples.clear();
+    writeSamples.clear();
+}
+
+void HeadlessOutput::flush(int buffer) {
+    if (!pending[buffer]) {
+        return;
+    }
+    pending[buffer] = false;
+    FrameTimes& times = pendingTimes[buffer];
+
+    uint64_t mapStart = Profiler::now();
+    const unsigned char* rgba = pbos[buffer].map<unsigned char>(GL_READ_ONLY);
+    uint64_t writeStart = Profiler::now();
+    times.mapMs = (writeStart - mapStart) * 0.001f;
+    if (rgba) {
+        write(rgba);
+    }
+    pbos[buffer].unmap();
+    times.writeMs = (Profiler::now() - writeStart) * 0.001f;
+
+    drawSamples.push_back(times.drawMs);
+    readbackSamples.push_back(times.copyMs + times.mapMs);
+    writeSamples.push_back(times.writeMs);
+    if (timesFile) {
+        fprintf(timesFile, "%llu,%.3f,%.3f,%.3f,%.3f\n", static_cast<unsigned long long>(times.frame), times.drawMs, times.copyMs, times.mapMs, times.writeMs);
+    }
+}
+
+// FBO rows come back top first, OF renders into FBOs flipped
+void HeadlessOutput::write(const unsigned char* rgba) {
+    if (format == DISCARD) {
+        return;
+    }
+
+    int width = settings.width, height = settings.height;
+    if (format == RAW) {
+        unsigned char* rgb = converted.data();
+        for (size_t i = 0, n = static_cast<size_t>(width) * height; i < n; ++i) {
+            rgb[i * 3] = rgba[i * 4];
+            rgb[i * 3 + 1] = rgba[i * 4 + 1];
+            rgb[i * 3 + 2] = rgba[i * 4 + 2];
+        }
+        fwrite(converted.data(), 1, converted.size(), file);
+        return;
+    }
+
+    // I420: full resolution luma, then U and V averaged over 2x2 blocks
+    int chromaWidth = (width + 1) / 2, chromaHeight = (height + 1) / 2;
+    unsigned char* luma = converted.data();
+    unsigned char* u = luma + static_cast<size_t>(width) * height;
+    unsigned char* v = u + chromaWidth * chromaHeight;
+    for (int y = 0; y < height; ++y) {
+        const unsigned char* row = rgba + static_cast<size_t>(y) * width * 4;
+        unsigned char* out = luma + static_cast<size_t>(y) * width;
+        for (int x = 0; x < width; ++x) {
+            out[x] = lumaOf(row[x * 4], row[x * 4 + 1], row[x * 4 + 2]);
+        }
+    }
+    for (int cy = 0; cy < chromaHeight; ++cy) {
+        int y0 = cy * 2, y1 = std::min(y0 + 1, height - 1);
+        for (int cx = 0; cx < chromaWidth; ++cx) {
+            int x0 = cx * 2, x1 = std::min(x0 + 1, width - 1);
+            const unsigned char* p[4] = {
+                rgba + (static_cast<size_t>(y0) * width + x0) * 4, rgba + (static_cast<size_t>(y0) * width + x1) * 4,
+                rgba + (static_cast<size_t>(y1) * width + x0) * 4, rgba + (static_cast<size_t>(y1) * width + x1) * 4};
+            int r = (p[0][0] + p[1][0] + p[2][0] + p[3][0] + 2) >> 2;
+            int g = (p[0][1] + p[1][1] + p[2][1] + p[3][1] + 2) >> 2;
+            int b = (p[0][2] + p[1][2] + p[2][2] + p[3][2] + 2) >> 2;
+            u[cy * chromaWidth + cx] = ((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128;
+            v[cy * chromaWidth + cx] = ((112 * r - 94 * g - 18 * b + 128) >> 8) + 128;
+        }
+    }
+    fputs("FRAME\n", file);
+    fwrite(converted.data(), 1, converted.size(), file);
+}
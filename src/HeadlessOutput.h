@@ -0,0 +1,66 @@
+#pragma once
+
+#include "ofMain.h"
+
+// Offscreen rendering for runs without a display. ofApp draws into an FBO at
+// the output resolution, frames are read back through two PBOs so the GPU
+// is a frame ahead of the readback, then written as Y4M (I420), headerless
+// RGB24 raw video, or discarded. Draw, readback and write times are reported
+// per frame and summarized on close.
+class HeadlessOutput {
+public:
+    struct Settings {
+        bool enabled = false;  // --headless
+        int width = 1920, height = 1080;
+        float frameRate = 30;
+        uint64_t frames = 0;   // Frames to render, 0 until the app is closed
+        string output;         // .y4m, any other extension is raw RGB24, empty discards
+        string times;          // Per frame timing CSV, none if empty
+        bool fixedStep = false; // Advance app time by exactly 1 / frameRate per frame
+    };
+
+    // Fill settings from the command line, prints usage and returns false on errors
+    static bool parseArguments(int argc, char* argv[], Settings& settings);
+
+    ~HeadlessOutput();
+
+    // Needs the GL context, call from ofApp::setup()
+    bool setup(const Settings& settings);
+
+    // Wrap the whole frame's drawing
+    void begin();
+    void end();
+
+    // Write the last frame still in flight, close the files and log the summary
+    void close();
+
+    bool isDone() const { return settings.frames > 0 && rendered >= settings.frames; }
+    uint64_t getNumRendered() const { return rendered; }
+
+private:
+    enum Format { DISCARD, RAW, Y4M };
+
+    struct FrameTimes {
+        uint64_t frame = 0;
+        float drawMs = 0, copyMs = 0, mapMs = 0, writeMs = 0;
+    };
+
+    void flush(int buffer);
+    void write(const unsigned char* rgba);
+
+    Settings settings;
+    Format format = DISCARD;
+    ofFbo fbo;
+    ofBufferObject pbos[2];
+    bool pending[2] = {false, false};
+    FrameTimes pendingTimes[2];
+
+    FILE* file = nullptr;
+    FILE* timesFile = nullptr;
+    vector<unsigned char> converted; // RGB24 or I420 frame being written
+
+    uint64_t rendered = 0;
+    uint64_t drawStart = 0; // Profiler::now(), app time may be fixed step
+    uint64_t runStart = 0;
+    vector<float> drawSamples, readbackSamples, writeSamples;
+};
@@ -0,0 +1,244 @@
+#include "InputPreprocessor.h"
+
+namespace {
+    // Byte offsets of the red, green and blue channels within a pixel
+    struct ChannelOffsets {
+        int r, g, b;
+    };
+
+    ChannelOffsets channelOffsets(ofPixelFormat format) {
+        switch (format) {
+            case OF_PIXELS_BGR:
+            case OF_PIXELS_BGRA:
+                return {2, 1, 0};
+            case OF_PIXELS_GRAY:
+                return {0, 0, 0};
+            default:
+                return {0, 1, 2};
+        }
+    }
+
+    const float NORMALIZE = 1 / 255.f;
+
+    // Luma and chroma of one pixel of a YUY2 or NV12 frame, read where they are
+    struct YuvFrame {
+        const unsigned char* data;
+        const unsigned char* chroma; // NV12's interleaved U V plane
+        size_t stride;               // Bytes per row, of each plane for NV12
+        bool nv12;
+
+        explicit YuvFrame(const ofPixels& src) : data(src.getData()), nv12(src.getPixelFormat() == OF_PIXELS_NV12) {
+            stride = nv12 ? src.getWidth() : src.getBytesStride();
+            chroma = data + stride * src.getHeight();
+        }
+
+        void sample(int x, int y, int& luma, int& u, int& v) const {
+            if (nv12) {
+                const unsigned char* c = chroma + (y >> 1) * stride + (x & ~1);
+                luma = data[y * stride + x];
+                u = c[0];
+                v = c[1];
+            } else {
+                const unsigned char* row = data + y * stride;
+                const unsigned char* c = row + (x & ~1) * 2; // Y0 U Y1 V
+                luma = row[x * 2];
+                u = c[1];
+                v = c[3];
+            }
+        }
+    };
+
+    // BT.601 limited range, y, u and v in 0-255 units, writes normalized RGB
+    inline float* yuvToRgb(float y, float u, float v, float* dst) {
+        y = 1.164f * (y - 16);
+        u -= 128;
+        v -= 128;
+        *dst++ = ofClamp((y + 1.596f * v) * NORMALIZE, 0, 1);
+        *dst++ = ofClamp((y - 0.392f * u - 0.813f * v) * NORMALIZE, 0, 1);
+        *dst++ = ofClamp((y + 2.017f * u) * NORMALIZE, 0, 1);
+        return dst;
+    }
+
+    bool isYuv(ofPixelFormat format) {
+        return format == OF_PIXELS_YUY2 || format == OF_PIXELS_NV12;
+    }
+}
+
+void InputPreprocessor::process(const ofPixels& src, const ofRectangle& roi, float* dst, int dstWidth, int dstHeight, Filter filter, float sampleDensity) {
+    if (!src.isAllocated() || dstWidth <= 0 || dstHeight <= 0) {
+        return;
+    }
+    updateTables(src, roi, dstWidth, dstHeight);
+    if (isYuv(src.getPixelFormat())) {
+        // Camera YUV is converted per output pixel, never as a whole frame
+        processYuv(src, dst, filter, sampleDensity);
+    } else if (filter == AREA) {
+        processArea(src, dst, sampleDensity);
+    } else {
+        processBilinear(src, dst);
+    }
+}
+
+void InputPreprocessor::updateTables(const ofPixels& src, const ofRectangle& roi, int dstWidth, int dstHeight) {
+    int srcWidth = src.getWidth();
+    int srcHeight = src.getHeight();
+    int bytesPerPixel = src.getBytesPerPixel();
+    if (roi == tableRoi && srcWidth == tableSrcWidth && srcHeight == tableSrcHeight && bytesPerPixel == tableBytesPerPixel &&
+        dstWidth == tableDstWidth && dstHeight == tableDstHeight) {
+        return;
+    }
+    tableRoi = roi;
+    tableSrcWidth = srcWidth;
+    tableSrcHeight = srcHeight;
+    tableBytesPerPixel = bytesPerPixel;
+    tableDstWidth = dstWidth;
+    tableDstHeight = dstHeight;
+
+    // Clamp the region to the frame, at least one pixel
+    int roiX = ofClamp(static_cast<int>(roi.x), 0, srcWidth - 1);
+    int roiY = ofClamp(static_cast<int>(roi.y), 0, srcHeight - 1);
+    int roiWidth = ofClamp(static_cast<int>(roi.width), 1, srcWidth - roiX);
+    int roiHeight = ofClamp(static_cast<int>(roi.height), 1, srcHeight - roiY);
+    float scaleX = roiWidth / static_cast<float>(dstWidth);
+    float scaleY = roiHeight / static_cast<float>(dstHeight);
+
+    x0.resize(dstWidth);
+    x1.resize(dstWidth);
+    fx.resize(dstWidth);
+    areaX0.resize(dstWidth);
+    areaX1.resize(dstWidth);
+    for (int x = 0; x < dstWidth; ++x) {
+        // Bilinear taps at pixel centers, stored as byte offsets into a row
+        float s = ofClamp((x + 0.5f) * scaleX - 0.5f, 0, roiWidth - 1);
+        int i = static_cast<int>(s);
+        x0[x] = (roiX + i) * bytesPerPixel;
+        x1[x] = (roiX + std::min(i + 1, roiWidth - 1)) * bytesPerPixel;
+        fx[x] = s - i;
+
+        // Area footprint as pixel columns [areaX0, areaX1)
+        areaX0[x] = roiX + static_cast<int>(x * scaleX);
+        areaX1[x] = std::max(areaX0[x] + 1, std::min(roiX + static_cast<int>((x + 1) * scaleX), roiX + roiWidth));
+    }
+
+    y0.resize(dstHeight);
+    y1.resize(dstHeight);
+    fy.resize(dstHeight);
+    areaY0.resize(dstHeight);
+    areaY1.resize(dstHeight);
+    for (int y = 0; y < dstHeight; ++y) {
+        float s = ofClamp((y + 0.5f) * scaleY - 0.5f, 0, roiHeight - 1);
+        int i = static_cast<int>(s);
+        y0[y] = roiY + i;
+        y1[y] = roiY + std::min(i + 1, roiHeight - 1);
+        fy[y] = s - i;
+
+        areaY0[y] = roiY + static_cast<int>(y * scaleY);
+        areaY1[y] = std::max(areaY0[y] + 1, std::min(roiY + static_cast<int>((y + 1) * scaleY), roiY + roiHeight));
+    }
+}
+
+void InputPreprocessor::processBilinear(const ofPixels& src, float* dst) {
+    const unsigned char* data = src.getData();
+    const size_t stride = src.getBytesStride();
+    const ChannelOffsets c = channelOffsets(src.getPixelFormat());
+
+    for (int y = 0; y < tableDstHeight; ++y) {
+        const unsigned char* row0 = data + y0[y] * stride;
+        const unsigned char* row1 = data + y1[y] * stride;
+        const float wy1 = fy[y] * NORMALIZE;
+        const float wy0 = NORMALIZE - wy1;
+        for (int x = 0; x < tableDstWidth; ++x) {
+            const unsigned char* p00 = row0 + x0[x];
+            const unsigned char* p01 = row0 + x1[x];
+            const unsigned char* p10 = row1 + x0[x];
+            const unsigned char* p11 = row1 + x1[x];
+            const float wx1 = fx[x];
+            const float wx0 = 1 - wx1;
+            const float w00 = wx0 * wy0, w01 = wx1 * wy0, w10 = wx0 * wy1, w11 = wx1 * wy1;
+            *dst++ = p00[c.r] * w00 + p01[c.r] * w01 + p10[c.r] * w10 + p11[c.r] * w11;
+            *dst++ = p00[c.g] * w00 + p01[c.g] * w01 + p10[c.g] * w10 + p11[c.g] * w11;
+            *dst++ = p00[c.b] * w00 + p01[c.b] * w01 + p10[c.b] * w10 + p11[c.b] * w11;
+        }
+    }
+}
+
+int InputPreprocessor::getSampleStep(float sampleDensity) {
+    return std::max(1, static_cast<int>(1 / ofClamp(sampleDensity, 0.01, 1) + 0.5f));
+}
+
+void InputPreprocessor::processArea(const ofPixels& src, float* dst, float sampleDensity) {
+    const unsigned char* data = src.getData();
+    const size_t stride = src.getBytesStride();
+    const int bytesPerPixel = tableBytesPerPixel;
+    const ChannelOffsets c = channelOffsets(src.getPixelFormat());
+    const int step = getSampleStep(sampleDensity);
+
+    for (int y = 0; y < tableDstHeight; ++y) {
+        for (int x = 0; x < tableDstWidth; ++x) {
+            unsigned int r = 0, g = 0, b = 0, count = 0;
+            for (int sy = areaY0[y]; sy < areaY1[y]; sy += step) {
+                const unsigned char* p = data + sy * stride + areaX0[x] * bytesPerPixel;
+                for (int sx = areaX0[x]; sx < areaX1[x]; sx += step, p += step * bytesPerPixel) {
+                    r += p[c.r];
+                    g += p[c.g];
+                    b += p[c.b];
+                    count++;
+                }
+            }
+            const float scale = NORMALIZE / count;
+            *dst++ = r * scale;
+            *dst++ = g * scale;
+            *dst++ = b * scale;
+        }
+    }
+}
+
+void InputPreprocessor::processYuv(const ofPixels& src, float* dst, Filter filter, float sampleDensity) {
+    const YuvFrame frame(src);
+    const int bytesPerPixel = tableBytesPerPixel;
+    int luma, u, v;
+
+    if (filter == AREA) {
+        // The conversion is linear, so averaging Y, U and V first gives the average RGB
+        const int step = getSampleStep(sampleDensity);
+        for (int y = 0; y < tableDstHeight; ++y) {
+            for (int x = 0; x < tableDstWidth; ++x) {
+                unsigned int sumLuma = 0, sumU = 0, sumV = 0, count = 0;
+                for (int sy = areaY0[y]; sy < areaY1[y]; sy += step) {
+                    for (int sx = areaX0[x]; sx < areaX1[x]; sx += step) {
+                        frame.sample(sx, sy, luma, u, v);
+                        sumLuma += luma;
+                        sumU += u;
+                        sumV += v;
+                        count++;
+                    }
+                }
+                const float scale = 1.f / count;
+                dst = yuvToRgb(sumLuma * scale, sumU * scale, sumV * scale, dst);
+            }
+        }
+        return;
+    }
+
+    for (int y = 0; y < tableDstHeight; ++y) {
+        const float wy1 = fy[y];
+        const float wy0 = 1 - wy1;
+        for (int x = 0; x < tableDstWidth; ++x) {
+            // The tables hold byte offsets, YUV samples are addressed by pixel
+            const int px0 = x0[x] / bytesPerPixel;
+            const int px1 = x1[x] / bytesPerPixel;
+            const float wx1 = fx[x];
+            const float wx0 = 1 - wx1;
+            const float w[4] = {wx0 * wy0, wx1 * wy0, wx0 * wy1, wx1 * wy1};
+            const int taps[4][2] = {{px0, y0[y]}, {px1, y0[y]}, {px0, y1[y]}, {px1, y1[y]}};
+            float sumLuma = 0, sumU = 0, sumV = 0;
+            for (int i = 0; i < 4; ++i) {
+                frame.sample(taps[i][0], taps[i][1], luma, u, v);
+                sumLuma += luma * w[i];
+                sumU += u * w[i];
+                sumV += v * w[i];
+            }
+            dst = yuvToRgb(sumLuma, sumU, sumV, dst);
+        }
+    }
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "ofMain.h"
+
+// Fused crop + resample + normalize from a camera frame straight into a
+// detector input buffer: reads the region of interest in place and writes
+// dstWidth x dstHeight float RGB pixels (0-1, row major, interleaved) in one pass.
+// YUY2 and NV12 frames are read as luma and chroma and converted per output pixel.
+class InputPreprocessor {
+public:
+    enum Filter {
+        BILINEAR, // 4 taps per output pixel, cheapest
+        AREA      // Box average over each output pixel's footprint, no aliasing when shrinking
+    };
+
+    // sampleDensity (0-1] thins out the source pixels averaged by the AREA filter
+    // per axis: it reads every round(1 / sampleDensity)th row and column, so 1
+    // reads every pixel in the footprint and 0.5 every other row and column,
+    // a quarter of the pixels
+    void process(const ofPixels& src, const ofRectangle& roi, float* dst, int dstWidth, int dstHeight, Filter filter, float sampleDensity = 1.0);
+
+    // Row and column step the AREA filter takes for sampleDensity
+    static int getSampleStep(float sampleDensity);
+
+    // sampleDensity snapped to the density its step actually samples, 1 / step
+    static float quantizeDensity(float sampleDensity) { return 1.f / getSampleStep(sampleDensity); }
+
+private:
+    void updateTables(const ofPixels& src, const ofRectangle& roi, int dstWidth, int dstHeight);
+    void processBilinear(const ofPixels& src, float* dst);
+    void processArea(const ofPixels& src, float* dst, float sampleDensity);
+    void processYuv(const ofPixels& src, float* dst, Filter filter, float sampleDensity);
+
+    // Per output column/row source offsets and weights, rebuilt only when the geometry changes
+    std::vector<int> x0, x1, y0, y1;
+    std::vector<float> fx, fy;
+    std::vector<int> areaX0, areaX1, areaY0, areaY1;
+
+    ofRectangle tableRoi;
+    int tableSrcWidth = 0, tableSrcHeight = 0, tableBytesPerPixel = 0;
+    int tableDstWidth = 0, tableDstHeight = 0;
+};
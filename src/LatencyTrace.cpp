@@ -0,0 +1,67 @@
+#include "LatencyTrace.h"
+
+void LatencyTrace::add(const Sample& sample) {
+    bool first = recent.empty();
+    recent.push_back(sample);
+    if (recent.size() > MAX_RECENT) {
+        recent.pop_front();
+    }
+    pending.push_back(sample);
+    if (pending.size() > MAX_PENDING) {
+        pending.pop_front();
+    }
+
+    float smoothing = first ? 1 : 0.1;
+    waitMs = ofLerp(waitMs, sample.getWaitMs(), smoothing);
+    inferenceMs = ofLerp(inferenceMs, sample.getInferenceMs(), smoothing);
+    applyMs = ofLerp(applyMs, sample.getApplyMs(), smoothing);
+    totalMs = ofLerp(totalMs, sample.getTotalMs(), smoothing);
+    framesBehind = ofLerp(framesBehind, sample.framesBehind, smoothing);
+}
+
+string LatencyTrace::getLabel() const {
+    if (recent.empty()) {
+        return "no results yet";
+    }
+    return ofToString(totalMs, 0) + " ms: wait " + ofToString(waitMs, 0) + ", inference " + ofToString(inferenceMs, 0) +
+           ", apply " + ofToString(applyMs, 0) + ", " + ofToString(framesBehind, 1) + " frames behind";
+}
+
+string LatencyTrace::getSummary() const {
+    if (recent.empty()) {
+        return "no results";
+    }
+    // p50 / p95 / max of one stage over the recent samples
+    vector<float> values(recent.size());
+    auto describe = [&](float (Sample::*stage)() const) {
+        std::transform(recent.begin(), recent.end(), values.begin(), [&](const Sample& sample) { return (sample.*stage)(); });
+        std::sort(values.begin(), values.end());
+        auto at = [&](float percentile) { return values[std::min(values.size() - 1, static_cast<size_t>(percentile * values.size()))]; };
+        return ofToString(at(0.5), 1) + " / " + ofToString(at(0.95), 1) + " / " + ofToString(values.back(), 1) + " ms";
+    };
+    return ofToString(recent.size()) + " results, p50 / p95 / max: capture to inference " + describe(&Sample::getWaitMs) +
+           ", inference " + describe(&Sample::getInferenceMs) + ", result to applied " + describe(&Sample::getApplyMs) +
+           ", capture to applied " + describe(&Sample::getTotalMs);
+}
+
+bool LatencyTrace::exportCsv(const string& path) {
+    ofFile file(path, ofFile::Append);
+    if (!file.is_open()) {
+        return false;
+    }
+    if (file.getSize() == 0) {
+        file << "frameId,captureMicros,waitMs,inferenceMs,applyMs,totalMs,framesBehind\n";
+    }
+    for (auto& sample : pending) {
+        file << sample.frameId << "," << sample.captureTime << "," << sample.getWaitMs() << "," << sample.getInferenceMs() << ","
+             << sample.getApplyMs() << "," << sample.getTotalMs() << "," << sample.framesBehind << "\n";
+    }
+    pending.clear();
+    return true;
+}
+
+void LatencyTrace::reset() {
+    recent.clear();
+    pending.clear();
+    waitMs = inferenceMs = applyMs = totalMs = framesBehind = 0;
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "ofMain.h"
+#include <deque>
+
+// End-to-end latency of the detection path per captured frame, from capture
+// to the update() that applies the frame's detection result to the focus.
+// Frames carry an ID and their capture time through the detection worker, the
+// result carries them back with its own timestamps and the main thread adds
+// one sample per applied result. Main thread only.
+class LatencyTrace {
+public:
+    // One applied result, times are ofGetElapsedTimeMicros()
+    struct Sample {
+        uint64_t frameId = 0;       // Frame the result was inferred from
+        uint64_t captureTime = 0;   // Oldest frame of the batch captured
+        uint64_t inferenceStart = 0; // Worker picked the batch up
+        uint64_t resultTime = 0;    // Result published, after inference, decode and tracking
+        uint64_t appliedTime = 0;   // update() applied it
+        uint64_t framesBehind = 0;  // Frames captured since the frame, when applied
+
+        float getWaitMs() const { return (inferenceStart - captureTime) * 0.001f; }
+        float getInferenceMs() const { return (resultTime - inferenceStart) * 0.001f; }
+        float getApplyMs() const { return (appliedTime - resultTime) * 0.001f; }
+        float getTotalMs() const { return (appliedTime - captureTime) * 0.001f; }
+    };
+
+    void add(const Sample& sample);
+
+    // Smoothed stage latencies for the GUI
+    string getLabel() const;
+
+    // Percentiles of each stage over the last MAX_RECENT samples, for the log
+    string getSummary() const;
+
+    // Append one row per sample since the last export, writing a header if the file is new
+    bool exportCsv(const string& path);
+
+    void reset();
+
+private:
+    static const size_t MAX_RECENT = 1024;
+    static const size_t MAX_PENDING = 65536; // Oldest samples are dropped while nothing exports
+
+    std::deque<Sample> recent, pending;
+    float waitMs = 0, inferenceMs = 0, applyMs = 0, totalMs = 0, framesBehind = 0;
+};
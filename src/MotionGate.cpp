@@ -0,0 +1,63 @@
+#include "MotionGate.h"
+
+float MotionGate::update(const ofPixels& frame, const ofRectangle& area) {
+    if (!frame.isAllocated()) {
+        return score;
+    }
+
+    int width = frame.getWidth();
+    int height = frame.getHeight();
+    int newStep = std::max(1, width / targetWidth);
+    int newGridWidth = width / newStep;
+    int newGridHeight = height / newStep;
+    bool resized = newGridWidth != gridWidth || newGridHeight != gridHeight;
+    if (resized) {
+        step = newStep;
+        gridWidth = newGridWidth;
+        gridHeight = newGridHeight;
+        current.assign(gridWidth * gridHeight, 0);
+        previous.assign(gridWidth * gridHeight, 0);
+    }
+    std::swap(current, previous);
+
+    // Sample luma on the coarse grid
+    const unsigned char* data = frame.getData();
+    // YUY2 and NV12 frames are sampled from their luma bytes, NV12's luma plane is one byte per pixel
+    const size_t stride = frame.getPixelFormat() == OF_PIXELS_NV12 ? width : frame.getBytesStride();
+    const int bytesPerPixel = frame.getBytesPerPixel();
+    const int r = frame.getPixelFormat() == OF_PIXELS_BGR || frame.getPixelFormat() == OF_PIXELS_BGRA ? 2 : 0;
+    const int b = 2 - r;
+    unsigned char* luma = current.data();
+    for (int y = 0; y < gridHeight; ++y) {
+        const unsigned char* p = data + (y * step) * stride;
+        for (int x = 0; x < gridWidth; ++x, p += step * bytesPerPixel) {
+            if (bytesPerPixel >= 3) {
+                *luma++ = (p[r] * 77 + p[1] * 150 + p[b] * 29) >> 8;
+            } else {
+                *luma++ = p[0];
+            }
+        }
+    }
+    if (resized) {
+        return score;
+    }
+
+    // Fraction of samples inside the area that changed
+    int x0 = ofClamp(area.x / step, 0, gridWidth);
+    int y0 = ofClamp(area.y / step, 0, gridHeight);
+    int x1 = ofClamp((area.x + area.width) / step, x0, gridWidth);
+    int y1 = ofClamp((area.y + area.height) / step, y0, gridHeight);
+    int changed = 0;
+    for (int y = y0; y < y1; ++y) {
+        const unsigned char* a = current.data() + y * gridWidth;
+        const unsigned char* c = previous.data() + y * gridWidth;
+        for (int x = x0; x < x1; ++x) {
+            changed += std::abs(a[x] - c[x]) > noiseFloor;
+        }
+    }
+    int samples = (x1 - x0) * (y1 - y0);
+    float fraction = samples > 0 ? changed / static_cast<float>(samples) : 0;
+
+    score = score * decay + fraction;
+    return score;
+}
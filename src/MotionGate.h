@@ -0,0 +1,36 @@
+#pragma once
+
+#include "ofMain.h"
+
+// Cheap motion detector used to skip inference while the scene is static.
+// Samples a coarse luma grid from each camera frame, counts the samples inside
+// the detection area whose luma changed by more than a noise floor and keeps a
+// leaky accumulated motion score from that fraction.
+class MotionGate {
+public:
+    // Feed a new camera frame, returns the accumulated motion score for area
+    float update(const ofPixels& frame, const ofRectangle& area);
+
+    // True if the accumulated score is at or above threshold
+    bool isTriggered(float threshold) const { return score >= threshold; }
+
+    float getScore() const { return score; }
+
+    // Coarse luma grid of the last frame, gridWidth x gridHeight, one byte per sample
+    const std::vector<unsigned char>& getLuma() const { return current; }
+    int getGridWidth() const { return gridWidth; }
+    int getGridHeight() const { return gridHeight; }
+    int getStep() const { return step; } // Camera pixels per grid sample
+
+    void setTargetWidth(int width) { targetWidth = width; }
+    void setNoiseFloor(int luma) { noiseFloor = luma; }
+    void setDecay(float factor) { decay = factor; }
+
+private:
+    std::vector<unsigned char> current, previous;
+    int gridWidth = 0, gridHeight = 0, step = 1;
+    int targetWidth = 160; // Grid samples across the frame
+    int noiseFloor = 12;   // Luma difference treated as sensor noise
+    float decay = 0.8;     // Fraction of the score carried over to the next frame
+    float score = 0;
+};
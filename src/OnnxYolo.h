@@ -0,0 +1,194 @@
+#pragma once
+
+#ifdef BLOWUP_ONNXRUNTIME
+
+#include "Detector.h"
+#include <onnxruntime_cxx_api.h>
+
+/// \class OnnxYolo
+/// \brief YOLO detector backend running an exported ONNX model on ONNX
+/// Runtime's CPU execution provider
+///
+/// expects the same model as ofxYolo exported to ONNX, ie. with tf2onnx:
+/// * input: B x H x W x 3 float RGB 0-1 (NHWC)
+/// * output: B x N x (4 + classes) rows of y1, x1, y2, x2 followed by class scores
+///
+/// the input buffer and, for models with a static output shape, the output
+/// buffer are allocated once and bound to the session, so inference copies
+/// nothing in or out
+///
+/// batching needs a dynamic batch dimension B, a model exported with a fixed
+/// batch size falls back to a batch size of 1
+///
+/// only built when BLOWUP_ONNXRUNTIME is defined, see config.make
+class OnnxYolo : public Detector {
+	public:
+
+		/// load an .onnx model file & object class names from a txt file (one name string per line),
+		/// returns true on success
+		bool setup(const std::string & modelPath="model.onnx", const std::string & classPath="classes.txt") override {
+			try {
+				Ort::SessionOptions options;
+				options.SetGraphOptimizationLevel(GraphOptimizationLevel::ORT_ENABLE_ALL);
+				if(intraOpThreads_ > 0) {
+					// a budgeted pool shouldn't busy-wait on its cores between inferences either
+					options.SetIntraOpNumThreads(intraOpThreads_);
+					options.AddConfigEntry("session.intra_op.allow_spinning", "0");
+				}
+				if(interOpThreads_ > 1) {
+					// inter-op threads are only used in parallel execution mode
+					options.SetExecutionMode(ExecutionMode::ORT_PARALLEL);
+					options.SetInterOpNumThreads(interOpThreads_);
+				}
+				std::string path = ofToDataPath(modelPath, true);
+			#ifdef _WIN32
+				session_ = Ort::Session(env_, std::wstring(path.begin(), path.end()).c_str(), options);
+			#else
+				session_ = Ort::Session(env_, path.c_str(), options);
+			#endif
+
+				// input, NHWC with a batch of batchSize_
+				Ort::AllocatorWithDefaultOptions allocator;
+				inputName_ = session_.GetInputNameAllocated(0, allocator).get();
+				inputShape_ = session_.GetInputTypeInfo(0).GetTensorTypeAndShapeInfo().GetShape();
+				if(inputShape_.size() != 4 || inputShape_[3] != 3) {
+					ofLogError("OnnxYolo") << "expected a B x H x W x 3 model input";
+					return false;
+				}
+				if(batchSize_ > 1 && inputShape_[0] > 0 && inputShape_[0] != batchSize_) {
+					ofLogWarning("OnnxYolo") << "model has a fixed batch size of " << inputShape_[0]
+					                         << ", running images one at a time";
+					setBatchSize(1);
+				}
+				if(inputShape_[1] > 0) {inputHeight_ = inputShape_[1];}
+				if(inputShape_[2] > 0) {inputWidth_ = inputShape_[2];}
+				inputShape_[1] = inputHeight_;
+				inputShape_[2] = inputWidth_;
+				inputData_.assign((size_t)batchSize_ * inputWidth_ * inputHeight_ * 3, 0);
+
+				// output, preallocated when the model's output shape is static apart from the batch
+				outputName_ = session_.GetOutputNameAllocated(0, allocator).get();
+				outputShape_ = session_.GetOutputTypeInfo(0).GetTensorTypeAndShapeInfo().GetShape();
+				if(outputShape_.empty()) {
+					ofLogError("OnnxYolo") << "model output has no shape";
+					return false;
+				}
+				rowSize_ = outputShape_.back();
+				outputData_.clear();
+				if(std::all_of(outputShape_.begin() + 1, outputShape_.end(), [](int64_t dim) {return dim > 0;})) {
+					size_t count = batchSize_;
+					for(size_t i = 1; i < outputShape_.size(); i++) {count *= outputShape_[i];}
+					outputData_.assign(count, 0);
+				}
+				binding_ = Ort::IoBinding(session_);
+				bindInput(1);
+			}
+			catch(const Ort::Exception & e) {
+				ofLogError("OnnxYolo") << "failed to load " << modelPath << ": " << e.what();
+				return false;
+			}
+
+			// object classes
+			return loadClasses(classPath, rowSize_ - 4);
+		}
+
+		/// clear model and classes
+		void clear() override {
+			binding_ = Ort::IoBinding(nullptr);
+			session_ = Ort::Session(nullptr);
+			Detector::clear();
+		}
+
+		std::string getName() const override {return "OnnxYolo";}
+		int getInputWidth() const override {return inputWidth_;}
+		int getInputHeight() const override {return inputHeight_;}
+
+		/// returns the persistent model input buffer, valid after setup()
+		float * getInputBuffer() override {return inputData_.data();}
+
+		/// run model on current input, blocking until finished,
+		/// returns true if objects are new
+		bool update() override {
+			if(!newInput_ || !session_) {
+				return false;
+			}
+			newInput_ = false;
+			uint64_t start = ofGetElapsedTimeMicros();
+			try {
+				session_.Run(Ort::RunOptions{nullptr}, binding_);
+			}
+			catch(const Ort::Exception & e) {
+				ofLogError("OnnxYolo") << "inference failed: " << e.what();
+				return false;
+			}
+			recordInference(ofGetElapsedTimeMicros() - start);
+
+			if(outputData_.empty()) { // dynamic output shape, allocated by the session
+				std::vector<Ort::Value> outputs = binding_.GetOutputValues();
+				size_t count = outputs[0].GetTensorTypeAndShapeInfo().GetElementCount();
+				parseObjects(outputs[0].GetTensorData<float>(), count / rowSize_, boundCount_);
+			}
+			else {
+				size_t count = outputData_.size() / batchSize_ * boundCount_;
+				parseObjects(outputData_.data(), count / rowSize_, boundCount_);
+			}
+			return true;
+		}
+
+	protected:
+
+		/// use the first count images of the input buffer as the next input
+		void submitInput(int count) override {
+			if(count != boundCount_) {
+				bindInput(count);
+			}
+			newInput_ = true;
+		}
+
+	private:
+
+		/// bind the first count images of the input and output buffers to the session
+		void bindInput(int count) {
+			if(!binding_) {
+				return;
+			}
+			std::vector<int64_t> inputShape = inputShape_;
+			inputShape[0] = count;
+			input_ = Ort::Value::CreateTensor<float>(memoryInfo_, inputData_.data(),
+			                                         inputData_.size() / batchSize_ * count,
+			                                         inputShape.data(), inputShape.size());
+			binding_.ClearBoundInputs();
+			binding_.ClearBoundOutputs();
+			binding_.BindInput(inputName_.c_str(), input_);
+			if(!outputData_.empty()) {
+				std::vector<int64_t> outputShape = outputShape_;
+				outputShape[0] = count;
+				output_ = Ort::Value::CreateTensor<float>(memoryInfo_, outputData_.data(),
+				                                          outputData_.size() / batchSize_ * count,
+				                                          outputShape.data(), outputShape.size());
+				binding_.BindOutput(outputName_.c_str(), output_);
+			}
+			else {
+				binding_.BindOutput(outputName_.c_str(), memoryInfo_);
+			}
+			boundCount_ = count;
+		}
+
+		Ort::Env env_{ORT_LOGGING_LEVEL_WARNING, "OnnxYolo"};
+		Ort::Session session_{nullptr};
+		Ort::IoBinding binding_{nullptr};
+		Ort::MemoryInfo memoryInfo_ = Ort::MemoryInfo::CreateCpu(OrtArenaAllocator, OrtMemTypeDefault);
+		std::string inputName_, outputName_;
+		std::vector<float> inputData_; ///< persistent input buffer
+		std::vector<float> outputData_; ///< persistent output buffer, empty for dynamic output shapes
+		Ort::Value input_{nullptr};
+		Ort::Value output_{nullptr};
+		std::vector<int64_t> inputShape_, outputShape_; ///< model shapes, the batch dim is set per run
+		int boundCount_ = 1; ///< images in the bound input
+		int inputWidth_ = 416;
+		int inputHeight_ = 416;
+		int64_t rowSize_ = 84; ///< floats per output row
+		bool newInput_ = false; ///< is the input new?
+};
+
+#endif
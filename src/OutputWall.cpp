@@ -0,0 +1,48 @@
+#include "OutputWall.h"
+
+OutputWall::Settings OutputWall::loadSettings(const string& file) {
+    Settings settings;
+    ofXml xml;
+    if (xml.load(file)) {
+        auto xmlSettings = xml.getChild("Settings");
+        if (xmlSettings.getChild("outputColumns")) {
+            settings.columns = std::max(1, xmlSettings.getChild("outputColumns").getIntValue());
+            settings.rows = std::max(1, xmlSettings.getChild("outputRows").getIntValue());
+            settings.windows = xmlSettings.getChild("outputWindows").getBoolValue();
+        }
+    }
+    return settings;
+}
+
+void OutputWall::setup(const Settings& wallSettings, float canvasWidth, float canvasHeight) {
+    settings = wallSettings;
+    float width = canvasWidth / settings.columns;
+    float height = canvasHeight / settings.rows;
+    areas.clear();
+    for (int row = 0; row < settings.rows; ++row) {
+        for (int column = 0; column < settings.columns; ++column) {
+            areas.emplace_back(column * width, row * height, width, height);
+        }
+    }
+}
+
+void OutputWall::begin(int output) {
+    const ofRectangle& area = areas[output];
+    inViewport = !settings.windows && areas.size() > 1;
+    if (inViewport) {
+        // The one window spans the canvas, so the area is also the viewport
+        ofPushView();
+        ofViewport(area);
+        ofSetupScreen();
+    }
+    ofPushMatrix();
+    ofTranslate(-area.x, -area.y);
+}
+
+void OutputWall::end() {
+    ofPopMatrix();
+    if (inViewport) {
+        ofPopView();
+        inViewport = false;
+    }
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "ofMain.h"
+
+// Splits the grid's canvas across the displays of a video wall, columns x rows
+// outputs of one display each. The grid layout is computed once per frame for
+// the whole canvas and each output only draws the cells that overlap it.
+// Outputs are either viewports of one window spanning all displays, or one
+// fullscreen window per display sharing the main window's GL context, so the
+// camera texture is uploaded once either way.
+class OutputWall {
+public:
+    struct Settings {
+        int columns = 1, rows = 1;
+        bool windows = false; // One window per output instead of viewports of one window
+        int getNumOutputs() const { return columns * rows; }
+    };
+
+    // Read the output settings from settings.xml, main() needs them before
+    // the windows are created, so before ofApp loads the rest
+    static Settings loadSettings(const string& file);
+
+    // Split a canvasWidth x canvasHeight canvas, outputs are numbered row by row
+    void setup(const Settings& settings, float canvasWidth, float canvasHeight);
+
+    int getNumOutputs() const { return areas.size(); }
+    bool usesWindows() const { return settings.windows && areas.size() > 1; }
+
+    // Output's part of the canvas, in canvas pixels
+    const ofRectangle& getArea(int output) const { return areas[output]; }
+
+    // Wrap drawing output's part of the canvas: in canvas pixels, to its own
+    // window or to its viewport of the one window
+    void begin(int output);
+    void end();
+
+private:
+    Settings settings;
+    vector<ofRectangle> areas = {ofRectangle()};
+    bool inViewport = false;
+};
+
+// Window of one output beyond the first, draws through the main app
+class OutputWindow : public ofBaseApp {
+public:
+    OutputWindow(std::function<void()> draw, std::function<void(int)> keyPressed)
+        : drawFunction(draw), keyPressedFunction(keyPressed) {}
+
+    void draw() override { drawFunction(); }
+    void keyPressed(int key) override { keyPressedFunction(key); }
+
+private:
+    std::function<void()> drawFunction;
+    std::function<void(int)> keyPressedFunction;
+};
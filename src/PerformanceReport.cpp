@@ -0,0 +1,43 @@
+#include "PerformanceReport.h"
+
+void PerformanceReport::Frames::add(float frameSeconds) {
+    if (frameSeconds <= 0) {
+        return;
+    }
+    count++;
+    seconds += frameSeconds;
+    smoothedFps = count == 1 ? 1 / frameSeconds : ofLerp(smoothedFps, 1 / frameSeconds, 0.05);
+}
+
+void PerformanceReport::addFrame(float frameSeconds, bool inferenceRunning) {
+    (inferenceRunning ? inferring : idle).add(frameSeconds);
+}
+
+void PerformanceReport::setInference(uint64_t count, double totalMs, float avgMs) {
+    inferences = count;
+    inferenceMs = totalMs;
+    avgInferenceMs = avgMs;
+}
+
+string PerformanceReport::getLabel() const {
+    return ofToString(idle.smoothedFps, 1) + " fps idle, " + ofToString(inferring.smoothedFps, 1) +
+           " fps inferring, inference " + ofToString(avgInferenceMs, 1) + " ms";
+}
+
+string PerformanceReport::getSummary() const {
+    double seconds = idle.seconds + inferring.seconds;
+    uint64_t count = inferences - startInferences;
+    double meanInferenceMs = count > 0 ? (inferenceMs - startInferenceMs) / count : 0;
+    float busy = seconds > 0 ? inferring.seconds / seconds : 0;
+    return ofToString(seconds, 0) + " s: " + ofToString(idle.getMeanFps(), 1) + " fps idle, " +
+           ofToString(inferring.getMeanFps(), 1) + " fps inferring (" + ofToString(busy * 100, 0) + "% of the time), " +
+           ofToString(count) + " inferences of " + ofToString(meanInferenceMs, 1) + " ms, " +
+           ofToString(seconds > 0 ? count / seconds : 0, 1) + " per second";
+}
+
+void PerformanceReport::reset() {
+    idle = Frames();
+    inferring = Frames();
+    startInferences = inferences;
+    startInferenceMs = inferenceMs;
+}
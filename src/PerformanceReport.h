@@ -0,0 +1,38 @@
+#pragma once
+
+#include "ofMain.h"
+
+// Achieved frame rate against inference latency, to divide cores between
+// rendering and inference deliberately. App frames are split by whether the
+// detection worker was inferring while they ran, so the report shows what
+// inference costs the render thread, next to what inference itself takes.
+class PerformanceReport {
+public:
+    // Record one app frame of frameSeconds, inferring: the worker was busy during it
+    void addFrame(float frameSeconds, bool inferring);
+
+    // Inferences so far and their summed duration, from Detector::Stats
+    void setInference(uint64_t inferences, double totalInferenceMs, float avgInferenceMs);
+
+    // Smoothed numbers for the GUI
+    string getLabel() const;
+
+    // Means since the last reset, for the log
+    string getSummary() const;
+
+    void reset();
+
+private:
+    struct Frames {
+        uint64_t count = 0;
+        double seconds = 0;
+        float smoothedFps = 0;
+        void add(float frameSeconds);
+        float getMeanFps() const { return seconds > 0 ? count / seconds : 0; }
+    };
+
+    Frames idle, inferring;
+    uint64_t startInferences = 0, inferences = 0;
+    double startInferenceMs = 0, inferenceMs = 0;
+    float avgInferenceMs = 0;
+};
@@ -0,0 +1,204 @@
+#include "Profiler.h"
+
+namespace {
+    std::atomic<uint64_t> nextProfilerId{1};
+
+    // Calling thread's buffer for the profiler with id, cached so record() only locks once per thread
+    struct LocalBuffer {
+        uint64_t profilerId = 0;
+        void* buffer = nullptr;
+    };
+    thread_local LocalBuffer localBuffer;
+
+    float percentile(vector<uint32_t>& samples, float p) {
+        size_t rank = std::min(samples.size() - 1, static_cast<size_t>(p * samples.size()));
+        std::nth_element(samples.begin(), samples.begin() + rank, samples.end());
+        return samples[rank] * 0.001f;
+    }
+}
+
+Profiler::Profiler() : id(nextProfilerId++) {
+}
+
+const char* Profiler::getName(Stage stage) {
+    switch (stage) {
+        case GRAB: return "grab";
+        case COPY: return "copy";
+        case DISPLAY_RESIZE: return "display resize";
+        case TEXTURE_UPLOAD: return "texture upload";
+        case MOTION: return "motion";
+        case FLOW: return "flow";
+        case PROCESS_FRAME: return "processFrame";
+        case PREPROCESS: return "preprocess";
+        case INFERENCE: return "inference";
+        case PARSE: return "parseObjects";
+        case TRACKING: return "tracking";
+        case DRAW: return "draw";
+        case GRID: return "grid";
+        default: return "?";
+    }
+}
+
+void Profiler::record(Stage stage, uint64_t micros) {
+    // Only this thread writes its buffer, plain loads and stores are enough
+    StageData& data = local().stages[stage];
+    uint32_t sample = std::min<uint64_t>(micros, UINT32_MAX);
+    uint64_t count = data.count.load(std::memory_order_relaxed);
+    data.samples[count % RING_SIZE].store(sample, std::memory_order_relaxed);
+    std::atomic<uint32_t>& bin = data.histogram[bucket(sample)];
+    bin.store(bin.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    data.totalMicros.store(data.totalMicros.load(std::memory_order_relaxed) + sample, std::memory_order_relaxed);
+    data.count.store(count + 1, std::memory_order_release);
+}
+
+void Profiler::setThreadName(const string& name) {
+    ThreadBuffer& buffer = local();
+    if (buffer.name != name) {
+        std::lock_guard<std::mutex> lock(registry);
+        buffer.name = name;
+    }
+}
+
+Profiler::ThreadBuffer& Profiler::local() {
+    if (localBuffer.profilerId != id) {
+        std::lock_guard<std::mutex> lock(registry);
+        threads.push_back(std::make_unique<ThreadBuffer>());
+        threads.back()->name = "thread " + ofToString(threads.size());
+        localBuffer.profilerId = id;
+        localBuffer.buffer = threads.back().get();
+    }
+    return *static_cast<ThreadBuffer*>(localBuffer.buffer);
+}
+
+void Profiler::summarize(vector<Summary>& summaries) {
+    summaries.clear();
+    std::lock_guard<std::mutex> lock(registry);
+    for (auto& thread : threads) {
+        for (int stage = 0; stage < NUM_STAGES; ++stage) {
+            StageData& data = thread->stages[stage];
+            uint64_t count = data.count.load(std::memory_order_acquire);
+            if (count == 0) {
+                continue;
+            }
+
+            // Samples may be overwritten while we copy, that only skews the window by a few samples
+            size_t n = std::min<uint64_t>(count, RING_SIZE);
+            scratch.resize(n);
+            uint64_t total = 0;
+            uint32_t maximum = 0;
+            for (size_t i = 0; i < n; ++i) {
+                scratch[i] = data.samples[(count - 1 - i) % RING_SIZE].load(std::memory_order_relaxed);
+                total += scratch[i];
+                maximum = std::max(maximum, scratch[i]);
+            }
+
+            Summary summary;
+            summary.thread = thread->name;
+            summary.stage = static_cast<Stage>(stage);
+            summary.count = n;
+            summary.meanMs = total * 0.001f / n;
+            summary.maxMs = maximum * 0.001f;
+            summary.p50Ms = percentile(scratch, 0.5);
+            summary.p95Ms = percentile(scratch, 0.95);
+            summary.p99Ms = percentile(scratch, 0.99);
+            summaries.push_back(summary);
+        }
+    }
+}
+
+void Profiler::draw(float x, float y) {
+    summarize(drawSummaries);
+    string text = "stage            thread         p50     p95     max  (ms)\n";
+    char line[128];
+    for (auto& summary : drawSummaries) {
+        snprintf(line, sizeof(line), "%-16s %-12s %7.2f %7.2f %7.2f\n", getName(summary.stage), summary.thread.c_str(),
+                 summary.p50Ms, summary.p95Ms, summary.maxMs);
+        text += line;
+    }
+    if (drawSummaries.empty()) {
+        text += "no samples yet\n";
+    }
+    ofDrawBitmapStringHighlight(text, x, y);
+}
+
+bool Profiler::exportCsv(const string& path) {
+    ofFile file(path, ofFile::Append);
+    if (!file.is_open()) {
+        return false;
+    }
+    if (file.getSize() == 0) {
+        file << "seconds,thread,stage,count,meanMs,p50Ms,p95Ms,p99Ms,maxMs\n";
+    }
+
+    float seconds = (ofGetElapsedTimeMillis() - startTime) * 0.001f;
+    std::lock_guard<std::mutex> lock(registry);
+    for (auto& thread : threads) {
+        for (int stage = 0; stage < NUM_STAGES; ++stage) {
+            StageData& data = thread->stages[stage];
+            uint64_t count = data.count.load(std::memory_order_acquire);
+            uint64_t micros = data.totalMicros.load(std::memory_order_relaxed);
+            uint64_t samples = count - thread->exportedCount[stage];
+            if (samples == 0) {
+                continue;
+            }
+
+            // Histogram of just this interval
+            uint32_t interval[BUCKETS];
+            uint64_t binned = 0;
+            for (int b = 0; b < BUCKETS; ++b) {
+                uint32_t value = data.histogram[b].load(std::memory_order_relaxed);
+                interval[b] = value - thread->exportedHistogram[stage][b];
+                thread->exportedHistogram[stage][b] = value;
+                binned += interval[b];
+            }
+            float percentiles[3] = {0.5, 0.95, 0.99};
+            float values[3] = {0, 0, 0};
+            float maximum = 0;
+            for (int p = 0; p < 3; ++p) {
+                uint64_t rank = std::ceil(percentiles[p] * binned);
+                uint64_t seen = 0;
+                for (int b = 0; b < BUCKETS; ++b) {
+                    seen += interval[b];
+                    if (seen >= rank && rank > 0) {
+                        values[p] = bucketMs(b);
+                        break;
+                    }
+                }
+            }
+            for (int b = BUCKETS - 1; b >= 0; --b) {
+                if (interval[b] > 0) {
+                    maximum = bucketMs(b);
+                    break;
+                }
+            }
+
+            file << ofToString(seconds, 1) << "," << thread->name << "," << getName(static_cast<Stage>(stage)) << "," << samples << ","
+                 << ofToString((micros - thread->exportedMicros[stage]) * 0.001f / samples, 3) << ","
+                 << values[0] << "," << values[1] << "," << values[2] << "," << maximum << "\n";
+            thread->exportedCount[stage] = count;
+            thread->exportedMicros[stage] = micros;
+        }
+    }
+    return true;
+}
+
+// Two buckets per power of two: [2^b, 1.5 * 2^b) and [1.5 * 2^b, 2^(b + 1))
+int Profiler::bucket(uint64_t micros) {
+    if (micros == 0) {
+        return 0;
+    }
+    int log2 = 63 - __builtin_clzll(micros);
+    int half = log2 > 0 ? (micros >> (log2 - 1)) & 1 : 0;
+    return std::min(BUCKETS - 1, 1 + log2 * 2 + half);
+}
+
+// Upper edge of a bucket in milliseconds
+float Profiler::bucketMs(int bucket) {
+    if (bucket == 0) {
+        return 0;
+    }
+    int log2 = (bucket - 1) / 2;
+    bool upperHalf = (bucket - 1) % 2;
+    float micros = upperHalf ? std::ldexp(1.f, log2 + 1) : std::ldexp(1.5f, log2);
+    return micros * 0.001f;
+}
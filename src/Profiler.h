@@ -0,0 +1,116 @@
+#pragma once
+
+#include "ofMain.h"
+
+// Low-overhead hot path timers. Every thread that records gets its own ring of
+// recent samples and a log2 histogram per stage, written without locks and
+// read by the main thread for the overlay and CSV export. While disabled a
+// Scope costs one relaxed atomic load.
+class Profiler {
+public:
+    enum Stage {
+        GRAB,           // frameSource->update()
+        COPY,           // Frame pool copy out of the frame source
+        DISPLAY_RESIZE, // CPU display resize
+        TEXTURE_UPLOAD, // Display texture upload
+        MOTION,         // Motion gate
+        FLOW,           // Optical flow
+        PROCESS_FRAME,  // Whole detection pass on the worker
+        PREPROCESS,     // Crop, resample and normalize into the model input
+        INFERENCE,      // Detector::update() without the decode
+        PARSE,          // Output decode and NMS
+        TRACKING,       // Person filter and tracker update
+        DRAW,           // Whole draw()
+        GRID,           // Grid geometry and its draw calls
+        NUM_STAGES
+    };
+
+    // Times its own lifetime into stage
+    class Scope {
+    public:
+        Scope(Profiler& profiler, Stage stage) : profiler(profiler), stage(stage), active(profiler.isEnabled()) {
+            if (active) {
+                start = now();
+            }
+        }
+        ~Scope() {
+            if (active) {
+                profiler.record(stage, now() - start);
+            }
+        }
+
+    private:
+        Profiler& profiler;
+        Stage stage;
+        bool active;
+        uint64_t start = 0;
+    };
+
+    Profiler();
+
+    struct Summary {
+        string thread;
+        Stage stage;
+        uint64_t count = 0;  // Samples in the window
+        float meanMs = 0, p50Ms = 0, p95Ms = 0, p99Ms = 0, maxMs = 0;
+    };
+
+    static const char* getName(Stage stage);
+
+    // Wall clock microseconds, unlike ofGetElapsedTimeMicros() it keeps running under ofSetTimeModeFixedRate()
+    static uint64_t now() {
+        return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    void setEnabled(bool enabled) { this->enabled.store(enabled, std::memory_order_relaxed); }
+    bool isEnabled() const { return enabled.load(std::memory_order_relaxed); }
+
+    // Record one sample on the calling thread
+    void record(Stage stage, uint64_t micros);
+
+    // Label the calling thread in the overlay and CSV, ie. "main"
+    void setThreadName(const string& name);
+
+    // Statistics over each thread's last RING_SIZE samples per stage
+    void summarize(vector<Summary>& summaries);
+
+    // Draw the summaries as a text table with its top left corner at x, y
+    void draw(float x, float y);
+
+    // Append one row per thread and stage with the histogram percentiles since
+    // the last export, writing a header if the file is new
+    bool exportCsv(const string& path);
+
+private:
+    static const int RING_SIZE = 256;
+    static const int BUCKETS = 64;  // Two per power of two microseconds
+
+    struct StageData {
+        std::atomic<uint32_t> samples[RING_SIZE];
+        std::atomic<uint32_t> histogram[BUCKETS];
+        std::atomic<uint64_t> count{0};
+        std::atomic<uint64_t> totalMicros{0};
+    };
+
+    struct ThreadBuffer {
+        string name;
+        StageData stages[NUM_STAGES];
+
+        // Reader side, histogram state at the last export
+        uint32_t exportedHistogram[NUM_STAGES][BUCKETS] = {};
+        uint64_t exportedCount[NUM_STAGES] = {};
+        uint64_t exportedMicros[NUM_STAGES] = {};
+    };
+
+    ThreadBuffer& local();
+    static int bucket(uint64_t micros);
+    static float bucketMs(int bucket);
+
+    const uint64_t id; // Tells this profiler's thread buffers apart from an earlier instance's
+    std::atomic<bool> enabled{false};
+    std::mutex registry; // Guards threads and names, taken once per thread and by readers
+    vector<std::unique_ptr<ThreadBuffer>> threads;
+    vector<uint32_t> scratch;
+    vector<Summary> drawSummaries;
+    uint64_t startTime = ofGetElapsedTimeMillis();
+};
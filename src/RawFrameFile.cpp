@@ -0,0 +1,254 @@
+#include "RawFrameFile.h"
+#include "YuvConverter.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+    const uint64_t PAGE = 4096;
+
+    uint64_t roundUp(uint64_t bytes, uint64_t multiple) {
+        return (bytes + multiple - 1) / multiple * multiple;
+    }
+}
+
+bool RawFrameHeader::isValid() const {
+    const char expected[8] = {'B', 'L', 'O', 'W', 'R', 'A', 'W', 0};
+    return std::equal(magic, magic + 8, expected) && version == VERSION && width > 0 && height > 0 &&
+           frameBytes == ofPixels::bytesFromPixelFormat(width, height, static_cast<ofPixelFormat>(pixelFormat)) &&
+           frameStride >= PIXELS_OFFSET + frameBytes;
+}
+
+//--------------------------------------------------------------
+RawFrameRecorder::~RawFrameRecorder() {
+    stop();
+}
+
+bool RawFrameRecorder::start(const string& path, int width, int height, ofPixelFormat format) {
+    stop();
+
+    header = RawFrameHeader();
+    header.width = width;
+    header.height = height;
+    header.pixelFormat = format;
+    header.frameBytes = ofPixels::bytesFromPixelFormat(width, height, format);
+    header.frameStride = roundUp(RawFrameHeader::PIXELS_OFFSET + header.frameBytes, PAGE);
+
+    file = fopen(ofToDataPath(path).c_str(), "wb");
+    if (!file) {
+        ofLogError("RawFrameRecorder") << "Can't open " << path;
+        return false;
+    }
+
+    // Header padded out to the first frame record
+    padding.assign(std::max(RawFrameHeader::DATA_OFFSET, header.frameStride - RawFrameHeader::PIXELS_OFFSET - header.frameBytes), 0);
+    fwrite(&header, sizeof(header), 1, file);
+    fwrite(padding.data(), 1, RawFrameHeader::DATA_OFFSET - sizeof(header), file);
+
+    written = 0;
+    dropped = 0;
+    queueHead = 0;
+    queueCount = 0;
+    startThread();
+    return true;
+}
+
+void RawFrameRecorder::stop() {
+    if (!file) {
+        return;
+    }
+
+    // The thread drains the queue before it exits
+    stopThread();
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+    }
+    queueReady.notify_all();
+    waitForThread(false);
+
+    header.numFrames = written;
+    fseek(file, 0, SEEK_SET);
+    fwrite(&header, sizeof(header), 1, file);
+    fclose(file);
+    file = nullptr;
+}
+
+bool RawFrameRecorder::add(const FramePool::Ref& frame) {
+    if (!file || !frame || frame->pixels.getTotalBytes() != header.frameBytes) {
+        return false;
+    }
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        if (queueCount == QUEUE_SIZE) {
+            dropped++; // Disk can't keep up, keep the app running smoothly instead
+            return false;
+        }
+        queue[(queueHead + queueCount) % QUEUE_SIZE] = frame;
+        queueCount++;
+    }
+    queueReady.notify_one();
+    return true;
+}
+
+void RawFrameRecorder::threadedFunction() {
+    while (true) {
+        FramePool::Ref frame;
+        {
+            std::unique_lock<std::mutex> lock(queueMutex);
+            queueReady.wait_for(lock, std::chrono::milliseconds(100), [this] {
+                return queueCount > 0 || !isThreadRunning();
+            });
+            if (queueCount == 0) {
+                if (!isThreadRunning()) {
+                    break;
+                }
+                continue;
+            }
+            frame = std::move(queue[queueHead]);
+            queueHead = (queueHead + 1) % QUEUE_SIZE;
+            queueCount--;
+        }
+
+        uint64_t captureTime = frame->captureTime;
+        fwrite(&captureTime, sizeof(captureTime), 1, file);
+        fwrite(padding.data(), 1, RawFrameHeader::PIXELS_OFFSET - sizeof(captureTime), file);
+        fwrite(frame->pixels.getData(), 1, header.frameBytes, file);
+        fwrite(padding.data(), 1, header.frameStride - RawFrameHeader::PIXELS_OFFSET - header.frameBytes, file);
+        written++;
+    }
+}
+
+//--------------------------------------------------------------
+RawFrameSource::RawFrameSource(const string& path, bool realtime, bool loop, ofPixelFormat convertTo)
+    : path(path), realtime(realtime), loop(loop), convertTo(convertTo) {
+}
+
+RawFrameSource::~RawFrameSource() {
+    close();
+}
+
+bool RawFrameSource::setup(int, int, float) {
+    close();
+
+    string fullPath = ofToDataPath(path);
+    int fd = open(fullPath.c_str(), O_RDONLY);
+    if (fd < 0) {
+        ofLogError("RawFrameSource") << "Can't open " << fullPath;
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || static_cast<uint64_t>(info.st_size) < RawFrameHeader::DATA_OFFSET ||
+        pread(fd, &header, sizeof(header), 0) != sizeof(header) || !header.isValid()) {
+        ofLogError("RawFrameSource") << fullPath << " is not a raw frame recording";
+        ::close(fd);
+        return false;
+    }
+    ofPixelFormat recorded = static_cast<ofPixelFormat>(header.pixelFormat);
+    if (convertTo != OF_PIXELS_UNKNOWN && (YuvConverter::isYuv(recorded) || recorded == OF_PIXELS_GRAY)) {
+        ofLogWarning("RawFrameSource") << "Only RGB recordings can be converted to YUV, replaying as recorded";
+        convertTo = OF_PIXELS_UNKNOWN;
+    }
+
+    // Private writable mapping so ofPixels can point into it, nothing writes through it
+    mappingSize = info.st_size;
+    void* mapped = mmap(nullptr, mappingSize, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapped == MAP_FAILED) {
+        ofLogError("RawFrameSource") << "Can't map " << fullPath;
+        return false;
+    }
+    mapping = static_cast<unsigned char*>(mapped);
+    madvise(mapping, mappingSize, MADV_SEQUENTIAL);
+
+    // A recording that was never stopped cleanly still plays up to its last complete frame
+    numFrames = (mappingSize - RawFrameHeader::DATA_OFFSET) / header.frameStride;
+    if (header.numFrames > 0) {
+        numFrames = std::min(numFrames, header.numFrames);
+    }
+    if (numFrames == 0) {
+        ofLogError("RawFrameSource") << fullPath << " has no frames";
+        close();
+        return false;
+    }
+
+    ofLogNotice("RawFrameSource") << "Replaying " << numFrames << " frames of " << header.width << "x" << header.height << " from " << fullPath;
+    show(0);
+    frameNew = false;
+    started = false;
+    return true;
+}
+
+void RawFrameSource::update() {
+    frameNew = false;
+    if (!mapping) {
+        return;
+    }
+
+    uint64_t now = ofGetElapsedTimeMicros();
+    if (!started) {
+        started = true;
+        startTime = now;
+        show(0);
+        return;
+    }
+
+    // Past the last frame, start over once it has been shown for a frame interval
+    if (index + 1 >= numFrames) {
+        uint64_t interval = numFrames > 1 ? (timestamp(numFrames - 1) - timestamp(0)) / (numFrames - 1) : 0;
+        if (loop && (!realtime || now - startTime >= timestamp(index) - timestamp(0) + interval)) {
+            startTime = now;
+            show(0);
+        }
+        return;
+    }
+
+    if (!realtime) {
+        show(index + 1);
+        return;
+    }
+
+    // Like a camera, skip to the newest frame that's due
+    uint64_t elapsed = now - startTime;
+    uint64_t due = index;
+    while (due + 1 < numFrames && timestamp(due + 1) - timestamp(0) <= elapsed) {
+        due++;
+    }
+    if (due != index) {
+        show(due);
+    }
+}
+
+void RawFrameSource::close() {
+    if (mapping) {
+        pixels.clear();
+        munmap(mapping, mappingSize);
+        mapping = nullptr;
+        mappingSize = 0;
+    }
+    numFrames = 0;
+    index = 0;
+    frameNew = false;
+    started = false;
+}
+
+uint64_t RawFrameSource::timestamp(uint64_t frame) const {
+    uint64_t captureTime;
+    memcpy(&captureTime, record(frame), sizeof(captureTime));
+    return captureTime;
+}
+
+void RawFrameSource::show(uint64_t frame) {
+    index = frame;
+    pixels.setFromExternalPixels(record(frame) + RawFrameHeader::PIXELS_OFFSET, header.width, header.height, static_cast<ofPixelFormat>(header.pixelFormat));
+    if (convertTo != OF_PIXELS_UNKNOWN) {
+        YuvConverter::fromRgb(pixels, convertTo, converted);
+    }
+    frameNew = true;
+
+    // Start paging in the next frame while this one is processed
+    if (frame + 1 < numFrames) {
+        madvise(record(frame + 1), header.frameStride, MADV_WILLNEED);
+    }
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include "ofMain.h"
+#include "FramePool.h"
+#include "FrameSource.h"
+
+// Raw frame recordings: a 4 KiB header followed by fixed-stride frame
+// records, each a capture timestamp padded to 64 bytes, the frame's pixels and
+// padding up to the next 4 KiB. Page-aligned records let the replay map the
+// file and hand out frames straight from the page cache. All fields are
+// native endian.
+struct RawFrameHeader {
+    static constexpr uint32_t VERSION = 1;
+    static constexpr uint64_t DATA_OFFSET = 4096;  // First frame record
+    static constexpr uint64_t PIXELS_OFFSET = 64;  // Pixels within a record
+
+    char magic[8] = {'B', 'L', 'O', 'W', 'R', 'A', 'W', 0};
+    uint32_t version = VERSION;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t pixelFormat = 0;   // ofPixelFormat
+    uint64_t frameBytes = 0;    // Pixel bytes per frame
+    uint64_t frameStride = 0;   // Bytes per frame record
+    uint64_t numFrames = 0;     // Written when recording stops, 0 if it never did
+
+    bool isValid() const;
+};
+
+// Writes FramePool frames to a raw recording on its own thread, so disk
+// writes never stall the app. Frames that arrive while the queue is full are
+// dropped and counted.
+class RawFrameRecorder : public ofThread {
+public:
+    ~RawFrameRecorder();
+
+    bool start(const string& path, int width, int height, ofPixelFormat format);
+    void stop();
+    bool isRecording() const { return file != nullptr; }
+
+    // Queue a frame, keeps a reference until it's written, false if dropped
+    bool add(const FramePool::Ref& frame);
+
+    uint64_t getNumWritten() const { return written; }
+    uint64_t getNumDropped() const { return dropped; }
+
+    static const int QUEUE_SIZE = 4; // Frames held on top of the app's own
+
+protected:
+    void threadedFunction() override;
+
+private:
+    FILE* file = nullptr;
+    RawFrameHeader header;
+    vector<char> padding;
+
+    std::mutex queueMutex;
+    std::condition_variable queueReady;
+    FramePool::Ref queue[QUEUE_SIZE];
+    int queueHead = 0, queueCount = 0;
+
+    std::atomic<uint64_t> written{0}, dropped{0};
+};
+
+// Replays a raw recording as a camera. The file is memory mapped and frames
+// are handed out in place, either at their recorded timing or one per
+// update() as fast as the app runs. RGB recordings can be converted to YUY2
+// or NV12 on replay, to stand in for a V4L2 camera on machines without one.
+class RawFrameSource : public FrameSource {
+public:
+    RawFrameSource(const string& path, bool realtime = true, bool loop = true, ofPixelFormat convertTo = OF_PIXELS_UNKNOWN);
+    ~RawFrameSource();
+
+    // Opens the recording, the requested size and rate are ignored
+    bool setup(int width, int height, float frameRate) override;
+    void update() override;
+    bool isFrameNew() const override { return frameNew; }
+    const ofPixels& getPixels() const override { return convertTo != OF_PIXELS_UNKNOWN ? converted : pixels; }
+    int getWidth() const override { return header.width; }
+    int getHeight() const override { return header.height; }
+    bool isInitialized() const override { return mapping != nullptr; }
+    void close() override;
+
+    uint64_t getNumFrames() const { return numFrames; }
+    uint64_t getFrameIndex() const { return index; }
+
+private:
+    unsigned char* record(uint64_t frame) const { return mapping + RawFrameHeader::DATA_OFFSET + frame * header.frameStride; }
+    uint64_t timestamp(uint64_t frame) const;
+    void show(uint64_t frame);
+
+    string path;
+    bool realtime, loop;
+    ofPixelFormat convertTo;
+
+    RawFrameHeader header;
+    unsigned char* mapping = nullptr;
+    size_t mappingSize = 0;
+    uint64_t numFrames = 0;
+
+    ofPixels pixels; // Points into the mapping
+    ofPixels converted; // YUV copy of pixels when converting
+    uint64_t index = 0;
+    bool frameNew = false;
+    bool started = false;
+    uint64_t startTime = 0; // Our clock when the first frame was shown
+};
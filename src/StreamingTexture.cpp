@@ -0,0 +1,186 @@
+#include "StreamingTexture.h"
+
+StreamingTexture::~StreamingTexture() {
+    for (auto& slot : slots) {
+        deleteFence(slot);
+    }
+}
+
+void StreamingTexture::setStreaming(bool enabled) {
+    streaming = enabled;
+}
+
+void StreamingTexture::loadData(const ofPixels& pixels) {
+    if (!streaming) {
+        // Synchronous upload into a texture that is shown right away
+        if (width != pixels.getWidth() || height != pixels.getHeight() || format != pixels.getPixelFormat()) {
+            allocate(pixels.getWidth(), pixels.getHeight(), pixels.getPixelFormat());
+        }
+        for (auto& slot : slots) {
+            deleteFence(slot);
+            slot.pending = false;
+        }
+        slots[0].texture.loadData(pixels.getData(), slots[0].texture.getWidth(), slots[0].texture.getHeight(), glFormat);
+        slots[0].sequence = ++sequence;
+        current = 0;
+        return;
+    }
+
+    unsigned char* data = beginWrite(pixels.getWidth(), pixels.getHeight(), pixels.getPixelFormat());
+    if (data) {
+        memcpy(data, pixels.getData(), std::min(bytes, pixels.getTotalBytes()));
+    }
+    endWrite();
+}
+
+unsigned char* StreamingTexture::beginWrite(size_t w, size_t h, ofPixelFormat f) {
+    if (w != width || h != height || f != format) {
+        allocate(w, h, f);
+    }
+
+    // Oldest slot that isn't on screen. If its last upload is still in flight a
+    // newer one replaces it, the GPU finishes the old one first.
+    writing = -1;
+    for (int i = 0; i < NUM_SLOTS; ++i) {
+        if (i != current && (writing < 0 || slots[i].sequence < slots[writing].sequence)) {
+            writing = i;
+        }
+    }
+    Slot& slot = slots[writing];
+    if (slot.pending) {
+        deleteFence(slot);
+        slot.pending = false;
+        dropped++;
+    }
+
+    // Orphan the buffer so mapping doesn't wait for the GPU to finish reading its last contents
+    slot.pbo.setData(bytes, nullptr, GL_STREAM_DRAW);
+    return slot.pbo.map<unsigned char>(GL_WRITE_ONLY);
+}
+
+void StreamingTexture::endWrite() {
+    if (writing < 0) {
+        return;
+    }
+    Slot& slot = slots[writing];
+    slot.pbo.unmap();
+
+    // Returns as soon as the copy is queued, the texture is written when the GPU gets to it
+    slot.texture.loadData(slot.pbo, glFormat, GL_UNSIGNED_BYTE);
+    slot.sequence = ++sequence;
+    slot.frame = ofGetFrameNum();
+    slot.pending = true;
+    if (useFences) {
+        slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+
+    if (!streaming || current < 0) {
+        // Synchronous, or nothing to show yet: show it now, sampling it waits for the upload
+        deleteFence(slot);
+        slot.pending = false;
+        current = writing;
+    }
+    writing = -1;
+}
+
+void StreamingTexture::update() {
+    // Newest upload whose fence has signaled, older ones in flight are superseded
+    int newest = -1;
+    for (int i = 0; i < NUM_SLOTS; ++i) {
+        Slot& slot = slots[i];
+        if (!slot.pending) {
+            continue;
+        }
+        bool done;
+        if (useFences) {
+            // The flush bit makes sure the fence is submitted, a timeout of 0 never blocks
+            GLenum status = glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+            done = status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED;
+        } else {
+            done = ofGetFrameNum() > slot.frame;
+        }
+        if (done && (newest < 0 || slot.sequence > slots[newest].sequence)) {
+            newest = i;
+        }
+    }
+    if (newest < 0) {
+        return;
+    }
+
+    for (int i = 0; i < NUM_SLOTS; ++i) {
+        Slot& slot = slots[i];
+        if (slot.pending && slot.sequence <= slots[newest].sequence) {
+            if (i != newest) {
+                dropped++;
+            }
+            deleteFence(slot);
+            slot.pending = false;
+        }
+    }
+    current = newest;
+}
+
+const ofTexture& StreamingTexture::getTexture() const {
+    return slots[current < 0 ? 0 : current].texture;
+}
+
+void StreamingTexture::draw(float x, float y, float w, float h) const {
+    if (current >= 0) {
+        slots[current].texture.draw(x, y, w, h);
+    }
+}
+
+void StreamingTexture::clear() {
+    for (auto& slot : slots) {
+        deleteFence(slot);
+        slot.pending = false;
+        slot.sequence = 0;
+        slot.texture.clear();
+        slot.pbo = ofBufferObject();
+    }
+    current = -1;
+    writing = -1;
+    width = height = bytes = 0;
+    format = OF_PIXELS_UNKNOWN;
+}
+
+void StreamingTexture::allocate(size_t w, size_t h, ofPixelFormat f) {
+    clear();
+    width = w;
+    height = h;
+    format = f;
+    bytes = ofPixels::bytesFromPixelFormat(w, h, f);
+    useFences = ofIsGLProgrammableRenderer() || ofGLCheckExtension("GL_ARB_sync");
+
+    if (f == OF_PIXELS_YUY2 || f == OF_PIXELS_NV12) {
+        // The frame's bytes as they are, one 8-bit channel per byte, for YuvConverter's shader
+        ofTextureData data;
+        data.textureTarget = GL_TEXTURE_RECTANGLE_ARB;
+        data.glInternalFormat = ofIsGLProgrammableRenderer() ? GL_R8 : GL_LUMINANCE8;
+        data.width = f == OF_PIXELS_YUY2 ? w * 2 : w;
+        data.height = f == OF_PIXELS_YUY2 ? h : h * 3 / 2;
+        data.tex_w = data.width;
+        data.tex_h = data.height;
+        glFormat = ofIsGLProgrammableRenderer() ? GL_RED : GL_LUMINANCE;
+        for (auto& slot : slots) {
+            slot.texture.allocate(data, glFormat, GL_UNSIGNED_BYTE);
+            slot.texture.setTextureMinMagFilter(GL_NEAREST, GL_NEAREST);
+        }
+    } else {
+        glFormat = ofGetGLFormatFromPixelFormat(f);
+        int internalFormat = ofGetGLInternalFormatFromPixelFormat(f);
+        for (auto& slot : slots) {
+            slot.texture.allocate(w, h, internalFormat, glFormat, GL_UNSIGNED_BYTE);
+        }
+    }
+    for (auto& slot : slots) {
+        slot.pbo.allocate(bytes, GL_STREAM_DRAW);
+    }
+}
+
+void StreamingTexture::deleteFence(Slot& slot) {
+    if (slot.fence) {
+        glDeleteSync(slot.fence);
+        slot.fence = nullptr;
+    }
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "ofMain.h"
+
+// Texture that uploads frames asynchronously through pixel buffer objects.
+// Each frame is copied into a mapped PBO and the texture upload is issued from
+// it, so the driver copies in the background instead of stalling the main
+// thread. There are three PBO and texture slots: the one being drawn and two
+// in flight. update() only switches to a new slot once a fence says its
+// upload has completed, so draw time doesn't depend on upload time. Without
+// sync objects (GL < 3.2 and no ARB_sync) an upload is shown a frame later.
+// YUY2 and NV12 frames are uploaded as their raw bytes for YuvConverter.
+class StreamingTexture {
+public:
+    static const int NUM_SLOTS = 3;
+
+    ~StreamingTexture();
+
+    // False uploads synchronously through ofTexture::loadData, for drivers with broken PBOs
+    void setStreaming(bool streaming);
+
+    // Queue pixels for upload, reallocates when the size or format changes
+    void loadData(const ofPixels& pixels);
+
+    // Map the next slot's PBO for width x height pixels of format. The memory
+    // may be filled on any thread, but beginWrite() and endWrite() need the GL
+    // thread. Returns nullptr when mapping fails, endWrite() must still be called.
+    unsigned char* beginWrite(size_t width, size_t height, ofPixelFormat format);
+    void endWrite();
+
+    // Show the newest completed upload, call once per frame before drawing
+    void update();
+
+    // Last completely uploaded frame, or the first upload until one has completed
+    const ofTexture& getTexture() const;
+    bool isAllocated() const { return current >= 0; }
+
+    void draw(float x, float y, float width, float height) const;
+
+    // Size and format of the frames loaded, the texture of a YUV frame has its raw byte layout
+    size_t getWidth() const { return width; }
+    size_t getHeight() const { return height; }
+    ofPixelFormat getPixelFormat() const { return format; }
+
+    // Changes whenever getTexture() switches to another upload
+    uint64_t getSequence() const { return current < 0 ? 0 : slots[current].sequence; }
+
+    // Uploads replaced by a newer one before they were shown
+    uint64_t getNumDropped() const { return dropped; }
+
+    // Free the GL objects, needs the GL thread
+    void clear();
+
+private:
+    struct Slot {
+        ofBufferObject pbo;
+        ofTexture texture;
+        GLsync fence = nullptr;
+        uint64_t sequence = 0; // Upload order, 0 if never uploaded
+        uint64_t frame = 0;    // ofGetFrameNum() of the upload, without fences
+        bool pending = false;
+    };
+
+    void allocate(size_t width, size_t height, ofPixelFormat format);
+    void deleteFence(Slot& slot);
+
+    Slot slots[NUM_SLOTS];
+    int current = -1;  // Slot getTexture() returns
+    int writing = -1;  // Slot between beginWrite() and endWrite()
+    size_t width = 0, height = 0, bytes = 0;
+    ofPixelFormat format = OF_PIXELS_UNKNOWN;
+    int glFormat = 0;
+    uint64_t sequence = 0;
+    uint64_t dropped = 0;
+    bool streaming = true;
+    bool useFences = false;
+};
@@ -0,0 +1,110 @@
+#include "ThreadAffinity.h"
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+bool ThreadAffinity::parseCores(const string& list, vector<int>& cores) {
+    cores.clear();
+    int numCores = getNumCores();
+    for (auto& entry : ofSplitString(list, ",", true, true)) {
+        vector<string> range = ofSplitString(entry, "-", false, true);
+        if (range.empty() || range.size() > 2 || range[0].empty() || range.back().empty() ||
+            range[0].find_first_not_of("0123456789") != string::npos || range.back().find_first_not_of("0123456789") != string::npos) {
+            ofLogError("ThreadAffinity") << "Malformed core list entry " << entry;
+            return false;
+        }
+        int first = ofToInt(range[0]);
+        int last = ofToInt(range.back());
+        if (first > last || last >= numCores) {
+            ofLogError("ThreadAffinity") << "Invalid core range " << entry << ", the cores are 0-" << numCores - 1;
+            return false;
+        }
+        for (int core = first; core <= last; ++core) {
+            if (std::find(cores.begin(), cores.end(), core) == cores.end()) {
+                cores.push_back(core);
+            }
+        }
+    }
+    return true;
+}
+
+bool ThreadAffinity::pinCurrentThread(const vector<int>& cores) {
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (cores.empty()) {
+        for (int core = 0; core < getNumCores() && core < CPU_SETSIZE; ++core) {
+            CPU_SET(core, &set);
+        }
+    } else {
+        for (int core : cores) {
+            if (core >= 0 && core < CPU_SETSIZE) {
+                CPU_SET(core, &set);
+            }
+        }
+    }
+    int error = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    if (error != 0) {
+        ofLogError("ThreadAffinity") << "Can't pin thread to cores " << describe(cores) << ": " << strerror(error);
+        return false;
+    }
+    return true;
+#else
+    if (!cores.empty()) {
+        static bool warned = false;
+        if (!warned) {
+            ofLogWarning("ThreadAffinity") << "Core pinning is only available on Linux";
+            warned = true;
+        }
+    }
+    return cores.empty();
+#endif
+}
+
+vector<int> ThreadAffinity::getCurrentCores() {
+    vector<int> cores;
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (pthread_getaffinity_np(pthread_self(), sizeof(set), &set) == 0) {
+        for (int core = 0; core < CPU_SETSIZE; ++core) {
+            if (CPU_ISSET(core, &set)) {
+                cores.push_back(core);
+            }
+        }
+        return cores;
+    }
+#endif
+    for (int core = 0; core < getNumCores(); ++core) {
+        cores.push_back(core);
+    }
+    return cores;
+}
+
+int ThreadAffinity::getNumCores() {
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+string ThreadAffinity::describe(const vector<int>& cores) {
+    if (cores.empty()) {
+        return "all";
+    }
+    // Collapse runs of consecutive cores into ranges
+    vector<int> sorted = cores;
+    std::sort(sorted.begin(), sorted.end());
+    string text;
+    for (size_t i = 0; i < sorted.size();) {
+        size_t last = i;
+        while (last + 1 < sorted.size() && sorted[last + 1] == sorted[last] + 1) {
+            ++last;
+        }
+        text += (text.empty() ? "" : ",") + ofToString(sorted[i]);
+        if (last > i) {
+            text += "-" + ofToString(sorted[last]);
+        }
+        i = last + 1;
+    }
+    return text;
+}
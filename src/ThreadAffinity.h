@@ -0,0 +1,28 @@
+#pragma once
+
+#include "ofMain.h"
+
+// Pins threads to sets of CPU cores, so inference, rendering and capture each
+// get their own cores instead of competing for all of them. Core lists are
+// written like "0-3,6", empty means all cores. Threads inherit the affinity
+// of the thread that starts them, which is how inference runtimes' internal
+// thread pools end up on the inference cores.
+//
+// Hard pinning needs Linux, elsewhere pinCurrentThread() logs once and
+// returns false; thread counts still apply.
+namespace ThreadAffinity {
+    // Parse a core list, returns false on malformed entries or cores the machine doesn't have
+    bool parseCores(const string& list, vector<int>& cores);
+
+    // Pin the calling thread to cores, empty unpins it to all cores
+    bool pinCurrentThread(const vector<int>& cores);
+
+    // Cores the calling thread may run on, all online cores if unknown
+    vector<int> getCurrentCores();
+
+    // Online cores
+    int getNumCores();
+
+    // Core list as text, "all" when empty
+    string describe(const vector<int>& cores);
+}
@@ -0,0 +1,219 @@
+#include "Tracker.h"
+
+namespace {
+    const float GATED = 1e4;      // Cost of a pair that must not be matched
+    const float MISS_DAMPING = 0.5; // Velocity kept per update without a match, stops lost tracks drifting off
+}
+
+glm::vec2 Tracker::Track::predict(uint64_t time) const {
+    if (time <= updateTime) {
+        return position;
+    }
+    return position + velocity * ((time - updateTime) * 0.001f);
+}
+
+void Tracker::setup(size_t newMaxTracks, size_t newMaxDetections) {
+    maxTracks = newMaxTracks;
+    maxDetections = newMaxDetections;
+    size_t n = std::max(maxTracks, maxDetections);
+
+    tracks.clear();
+    tracks.reserve(maxTracks);
+    detections.clear();
+    detections.reserve(maxDetections);
+    cost.reserve(n * n);
+    u.reserve(n + 1);
+    v.reserve(n + 1);
+    minv.reserve(n + 1);
+    p.reserve(n + 1);
+    way.reserve(n + 1);
+    used.reserve(n + 1);
+    assignment.reserve(n);
+}
+
+void Tracker::clear() {
+    tracks.clear();
+    detections.clear();
+}
+
+void Tracker::clearDetections() {
+    detections.clear();
+}
+
+void Tracker::addDetection(const ofRectangle& box, const glm::vec2& position, float size) {
+    if (detections.size() < maxDetections) {
+        detections.push_back({box, position, size});
+    }
+}
+
+void Tracker::update(uint64_t time, float maxDistance, float minMovement) {
+    for (auto& track : tracks) {
+        predict(track, time);
+    }
+
+    int numTracks = tracks.size();
+    int numDetections = detections.size();
+    int n = std::max(numTracks, numDetections);
+    if (n == 0) {
+        return;
+    }
+
+    // Square cost matrix, rows are tracks and columns detections, padding costs nothing
+    cost.assign(n * n, 0);
+    for (int i = 0; i < numTracks; ++i) {
+        const Track& track = tracks[i];
+        ofRectangle predictedBox = track.box;
+        predictedBox.translate(track.position - track.measured);
+        for (int j = 0; j < numDetections; ++j) {
+            float distance = glm::distance(track.position, detections[j].position);
+            cost[i * n + j] = distance < maxDistance ? (1 - iou(predictedBox, detections[j].box)) + distance / maxDistance : GATED;
+        }
+    }
+    solveAssignment(n);
+
+    // Matched tracks take their detection, the rest coast. used is free again and marks taken detections.
+    std::fill(used.begin(), used.end(), 0);
+    for (int i = 0; i < numTracks; ++i) {
+        Track& track = tracks[i];
+        int j = assignment[i];
+        if (j < numDetections && cost[i * n + j] < GATED) {
+            const Detection& detection = detections[j];
+            if (glm::distance(detection.position, track.measured) > minMovement) {
+                track.moveTimestamp = time;
+            }
+            correct(track, detection.position);
+            track.box = detection.box;
+            track.measured = detection.position;
+            track.size = detection.size;
+            track.hits++;
+            track.misses = 0;
+            used[j] = 1;
+        } else {
+            track.velocity *= MISS_DAMPING;
+            track.misses++;
+        }
+    }
+
+    // Unmatched detections start new tracks
+    for (int j = 0; j < numDetections && tracks.size() < maxTracks; ++j) {
+        if (used[j]) {
+            continue;
+        }
+        const Detection& detection = detections[j];
+        Track track;
+        track.id = nextId++;
+        track.box = detection.box;
+        track.measured = detection.position;
+        track.position = detection.position;
+        track.size = detection.size;
+        track.updateTime = time;
+        track.moveTimestamp = time;
+        track.hits = 1;
+        track.covX[0] = track.covY[0] = measurementNoise;
+        track.covX[2] = track.covY[2] = initialVelocityNoise;
+        tracks.push_back(track);
+    }
+}
+
+void Tracker::expire(uint64_t time, uint64_t timeout) {
+    tracks.erase(std::remove_if(tracks.begin(), tracks.end(), [&](const Track& track) {
+        return time - track.moveTimestamp > timeout;
+    }), tracks.end());
+}
+
+void Tracker::predict(Track& track, uint64_t time) const {
+    if (time <= track.updateTime) {
+        return;
+    }
+    float dt = (time - track.updateTime) * 0.001f;
+    float q = processNoise;
+    track.position += track.velocity * dt;
+    track.updateTime = time;
+
+    // P = F P F^T + Q for each axis of the constant-velocity model
+    for (float* cov : {track.covX, track.covY}) {
+        cov[0] += 2 * dt * cov[1] + dt * dt * cov[2] + q * dt * dt * dt * dt * 0.25f;
+        cov[1] += dt * cov[2] + q * dt * dt * dt * 0.5f;
+        cov[2] += q * dt * dt;
+    }
+}
+
+void Tracker::correct(Track& track, const glm::vec2& measurement) const {
+    float* covs[2] = {track.covX, track.covY};
+    for (int axis = 0; axis < 2; ++axis) {
+        float* cov = covs[axis];
+        float s = cov[0] + measurementNoise;
+        float k0 = cov[0] / s;
+        float k1 = cov[1] / s;
+        float residual = measurement[axis] - track.position[axis];
+        track.position[axis] += k0 * residual;
+        track.velocity[axis] += k1 * residual;
+        cov[2] -= k1 * cov[1];
+        cov[1] *= 1 - k0;
+        cov[0] *= 1 - k0;
+    }
+}
+
+// Hungarian algorithm with potentials, O(n^3) on the square cost matrix.
+// Leaves the column assigned to each row in assignment.
+void Tracker::solveAssignment(int n) {
+    const float inf = std::numeric_limits<float>::max();
+    u.assign(n + 1, 0);
+    v.assign(n + 1, 0);
+    p.assign(n + 1, 0);
+    way.assign(n + 1, 0);
+    for (int i = 1; i <= n; ++i) {
+        p[0] = i;
+        int j0 = 0;
+        minv.assign(n + 1, inf);
+        used.assign(n + 1, 0);
+        do {
+            used[j0] = 1;
+            int i0 = p[j0];
+            int j1 = 0;
+            float delta = inf;
+            for (int j = 1; j <= n; ++j) {
+                if (!used[j]) {
+                    float current = cost[(i0 - 1) * n + (j - 1)] - u[i0] - v[j];
+                    if (current < minv[j]) {
+                        minv[j] = current;
+                        way[j] = j0;
+                    }
+                    if (minv[j] < delta) {
+                        delta = minv[j];
+                        j1 = j;
+                    }
+                }
+            }
+            for (int j = 0; j <= n; ++j) {
+                if (used[j]) {
+                    u[p[j]] += delta;
+                    v[j] -= delta;
+                } else {
+                    minv[j] -= delta;
+                }
+            }
+            j0 = j1;
+        } while (p[j0] != 0);
+        do {
+            int j1 = way[j0];
+            p[j0] = p[j1];
+            j0 = j1;
+        } while (j0 != 0);
+    }
+
+    assignment.assign(n, 0);
+    for (int j = 1; j <= n; ++j) {
+        assignment[p[j] - 1] = j - 1;
+    }
+}
+
+float Tracker::iou(const ofRectangle& a, const ofRectangle& b) {
+    float w = std::min(a.getRight(), b.getRight()) - std::max(a.getLeft(), b.getLeft());
+    float h = std::min(a.getBottom(), b.getBottom()) - std::max(a.getTop(), b.getTop());
+    if (w <= 0 || h <= 0) {
+        return 0;
+    }
+    float intersection = w * h;
+    return intersection / (a.getArea() + b.getArea() - intersection);
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "ofMain.h"
+
+// Multi-person tracker for the detection worker. Detections are assigned to
+// tracks with the Hungarian algorithm on an IoU plus center distance cost, and
+// every track carries a constant-velocity Kalman state so its position can be
+// extrapolated between sparse detections. All buffers are sized in setup(), so
+// steady-state updates don't allocate. Positions can be in any unit, the noise
+// defaults assume normalized 0-1 coordinates.
+class Tracker {
+public:
+    struct Track {
+        int id = 0;
+        ofRectangle box;              // Last matched bounding box
+        glm::vec2 measured;           // Last matched position
+        glm::vec2 position;           // Filtered position at updateTime
+        glm::vec2 velocity;           // Filtered velocity, units per second
+        float size = 0;               // Last matched box area
+        uint64_t updateTime = 0;      // Milliseconds, time of position and velocity
+        uint64_t moveTimestamp = 0;   // Milliseconds, last time the person moved more than minMovement
+        int hits = 0;                 // Detections matched to this track
+        int misses = 0;               // Consecutive updates without a match
+
+        // Constant-velocity extrapolation from updateTime to time
+        glm::vec2 predict(uint64_t time) const;
+
+    private:
+        friend class Tracker;
+        float covX[3] = {0, 0, 0};    // Per axis [var(p), cov(p,v), var(v)]
+        float covY[3] = {0, 0, 0};
+    };
+
+    void setup(size_t maxTracks = 32, size_t maxDetections = 64);
+    void clear();
+
+    // Collect this frame's detections, then call update() once
+    void clearDetections();
+    void addDetection(const ofRectangle& box, const glm::vec2& position, float size);
+
+    // Advance every track to time, assign the collected detections and start
+    // tracks for the unmatched ones. Pairs further apart than maxDistance are
+    // never matched, moves larger than minMovement refresh moveTimestamp.
+    void update(uint64_t time, float maxDistance, float minMovement);
+
+    // Drop tracks whose moveTimestamp is older than timeout
+    void expire(uint64_t time, uint64_t timeout);
+
+    const std::vector<Track>& getTracks() const { return tracks; }
+
+    void setProcessNoise(float accelerationVariance) { processNoise = accelerationVariance; }
+    void setMeasurementNoise(float positionVariance) { measurementNoise = positionVariance; }
+
+protected:
+    struct Detection {
+        ofRectangle box;
+        glm::vec2 position;
+        float size;
+    };
+
+    void predict(Track& track, uint64_t time) const;
+    void correct(Track& track, const glm::vec2& measurement) const;
+    void solveAssignment(int n);
+    static float iou(const ofRectangle& a, const ofRectangle& b);
+
+    std::vector<Track> tracks;
+    std::vector<Detection> detections;
+    size_t maxTracks = 0, maxDetections = 0;
+    int nextId = 1;
+
+    float processNoise = 1;         // Acceleration variance, (units / s^2)^2
+    float measurementNoise = 1e-4;  // Position variance, units^2
+    float initialVelocityNoise = 1; // Velocity variance of a new track, (units / s)^2
+
+    // Assignment scratch, square n x n with n = max(tracks, detections)
+    std::vector<float> cost;
+    std::vector<float> u, v, minv;
+    std::vector<int> p, way, assignment;
+    std::vector<char> used;
+};
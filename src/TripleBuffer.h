@@ -0,0 +1,52 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+// Lock-free single producer / single consumer triple buffer. The writer fills
+// getWriteBuffer() and publish()es it, the reader picks up the newest
+// published value with update() and reads getReadBuffer(). Neither side ever
+// blocks or sees a half-written value; values published faster than they are
+// read are overwritten, newest wins.
+template<typename T>
+class TripleBuffer {
+public:
+    TripleBuffer() : middle(MIDDLE), back(BACK), front(FRONT) {}
+
+    // Writer side: the buffer to fill before publish()
+    T& getWriteBuffer() { return buffers[back]; }
+
+    // Writer side: make the write buffer the newest value. Returns true if the
+    // previously published value was never read; it is now the write buffer.
+    bool publish() {
+        uint8_t previous = middle.exchange(back | DIRTY, std::memory_order_acq_rel);
+        back = previous & INDEX;
+        return previous & DIRTY;
+    }
+
+    // Reader side: switch to the newest published value, returns false if nothing new
+    bool update() {
+        if (!hasNew()) {
+            return false;
+        }
+        uint8_t previous = middle.exchange(front, std::memory_order_acq_rel);
+        front = previous & INDEX;
+        return true;
+    }
+
+    // Reader side: the value picked up by the last update()
+    T& getReadBuffer() { return buffers[front]; }
+    const T& getReadBuffer() const { return buffers[front]; }
+
+    // True if a value was published and not yet picked up, safe from either side
+    bool hasNew() const { return middle.load(std::memory_order_acquire) & DIRTY; }
+
+private:
+    static const uint8_t FRONT = 0, MIDDLE = 1, BACK = 2;
+    static const uint8_t INDEX = 0x3, DIRTY = 0x4;
+
+    T buffers[3];
+    std::atomic<uint8_t> middle; // Index of the shared buffer plus the DIRTY flag
+    uint8_t back;  // Owned by the writer
+    uint8_t front; // Owned by the reader
+};
@@ -0,0 +1,210 @@
+#include "V4L2Source.h"
+
+#ifdef __linux__
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <linux/videodev2.h>
+
+namespace {
+    // ioctl that retries when a signal interrupts it
+    int xioctl(int fd, unsigned long request, void* arg) {
+        int result;
+        do {
+            result = ioctl(fd, request, arg);
+        } while (result < 0 && errno == EINTR);
+        return result;
+    }
+}
+#endif
+
+V4L2Source::V4L2Source(const string& device) : device(device) {
+}
+
+V4L2Source::~V4L2Source() {
+    close();
+}
+
+bool V4L2Source::setup(int requestedWidth, int requestedHeight, float frameRate) {
+#ifdef __linux__
+    close();
+    fd = ::open(device.c_str(), O_RDWR | O_NONBLOCK);
+    if (fd < 0) {
+        ofLogError("V4L2Source") << "Can't open " << device << ": " << strerror(errno);
+        return false;
+    }
+
+    v4l2_capability capability = {};
+    if (xioctl(fd, VIDIOC_QUERYCAP, &capability) < 0 ||
+        !(capability.capabilities & V4L2_CAP_VIDEO_CAPTURE) || !(capability.capabilities & V4L2_CAP_STREAMING)) {
+        ofLogError("V4L2Source") << device << " is not a streaming capture device";
+        close();
+        return false;
+    }
+
+    // YUYV first, UVC cameras offer it at most sizes, then NV12. MJPEG-only modes aren't supported.
+    v4l2_format fmt = {};
+    bool found = false;
+    for (uint32_t fourcc : {V4L2_PIX_FMT_YUYV, V4L2_PIX_FMT_NV12}) {
+        fmt = {};
+        fmt.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+        fmt.fmt.pix.width = requestedWidth;
+        fmt.fmt.pix.height = requestedHeight;
+        fmt.fmt.pix.pixelformat = fourcc;
+        fmt.fmt.pix.field = V4L2_FIELD_NONE;
+        if (xioctl(fd, VIDIOC_S_FMT, &fmt) == 0 && fmt.fmt.pix.pixelformat == fourcc) {
+            found = true;
+            break;
+        }
+    }
+    if (!found) {
+        ofLogError("V4L2Source") << device << " offers neither YUYV nor NV12";
+        close();
+        return false;
+    }
+    width = fmt.fmt.pix.width;
+    height = fmt.fmt.pix.height;
+    bytesPerLine = fmt.fmt.pix.bytesperline;
+    format = fmt.fmt.pix.pixelformat == V4L2_PIX_FMT_YUYV ? OF_PIXELS_YUY2 : OF_PIXELS_NV12;
+
+    // The driver picks the nearest rate it supports, not all drivers let us choose
+    v4l2_streamparm parameters = {};
+    parameters.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    parameters.parm.capture.timeperframe.numerator = 1000;
+    parameters.parm.capture.timeperframe.denominator = frameRate * 1000;
+    xioctl(fd, VIDIOC_S_PARM, &parameters);
+
+    v4l2_requestbuffers request = {};
+    request.count = NUM_BUFFERS;
+    request.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    request.memory = V4L2_MEMORY_MMAP;
+    if (xioctl(fd, VIDIOC_REQBUFS, &request) < 0 || request.count < 2) {
+        ofLogError("V4L2Source") << "Can't get capture buffers from " << device;
+        close();
+        return false;
+    }
+    for (uint32_t i = 0; i < request.count; ++i) {
+        v4l2_buffer buffer = {};
+        buffer.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+        buffer.memory = V4L2_MEMORY_MMAP;
+        buffer.index = i;
+        if (xioctl(fd, VIDIOC_QUERYBUF, &buffer) < 0) {
+            ofLogError("V4L2Source") << "Can't query capture buffer " << i;
+            close();
+            return false;
+        }
+        void* start = mmap(nullptr, buffer.length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, buffer.m.offset);
+        if (start == MAP_FAILED) {
+            ofLogError("V4L2Source") << "Can't map capture buffer " << i;
+            close();
+            return false;
+        }
+        buffers.push_back({start, buffer.length});
+        if (xioctl(fd, VIDIOC_QBUF, &buffer) < 0) {
+            ofLogError("V4L2Source") << "Can't queue capture buffer " << i;
+            close();
+            return false;
+        }
+    }
+
+    v4l2_buf_type type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    if (xioctl(fd, VIDIOC_STREAMON, &type) < 0) {
+        ofLogError("V4L2Source") << "Can't start streaming from " << device;
+        close();
+        return false;
+    }
+
+    // The third buffer is allocated by the capture thread on its second frame
+    frames.getReadBuffer().allocate(width, height, format);
+    frames.getWriteBuffer().allocate(width, height, format);
+    frameNew = false;
+    captured = 0;
+    dropped = 0;
+    startThread();
+
+    ofLogNotice("V4L2Source") << "Capturing " << width << "x" << height << (format == OF_PIXELS_YUY2 ? " YUYV" : " NV12") << " from " << device;
+    return true;
+#else
+    ofLogError("V4L2Source") << "V4L2 capture is only available on Linux";
+    return false;
+#endif
+}
+
+void V4L2Source::update() {
+    frameNew = frames.update();
+}
+
+void V4L2Source::close() {
+#ifdef __linux__
+    if (isThreadRunning()) {
+        waitForThread(true);
+    }
+    if (fd >= 0) {
+        v4l2_buf_type type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+        xioctl(fd, VIDIOC_STREAMOFF, &type);
+    }
+    for (auto& buffer : buffers) {
+        munmap(buffer.start, buffer.length);
+    }
+    buffers.clear();
+    if (fd >= 0) {
+        ::close(fd);
+        fd = -1;
+    }
+#endif
+    frameNew = false;
+}
+
+void V4L2Source::threadedFunction() {
+#ifdef __linux__
+    while (isThreadRunning()) {
+        // Wake up regularly to notice stopThread()
+        pollfd descriptor = {fd, POLLIN, 0};
+        if (poll(&descriptor, 1, 100) <= 0) {
+            continue;
+        }
+
+        v4l2_buffer buffer = {};
+        buffer.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+        buffer.memory = V4L2_MEMORY_MMAP;
+        if (xioctl(fd, VIDIOC_DQBUF, &buffer) < 0) {
+            if (errno == EAGAIN) {
+                continue;
+            }
+            ofLogError("V4L2Source") << "Capture from " << device << " failed: " << strerror(errno);
+            break;
+        }
+
+        // Copy out and hand the buffer straight back, the camera never waits for the app
+        if (!(buffer.flags & V4L2_BUF_FLAG_ERROR) && buffer.index < buffers.size()) {
+            ofPixels& pixels = frames.getWriteBuffer();
+            if (!pixels.isAllocated()) {
+                pixels.allocate(width, height, format);
+            }
+            copyFrame(static_cast<const unsigned char*>(buffers[buffer.index].start), buffer.bytesused, pixels);
+            if (frames.publish()) {
+                dropped++;
+            }
+            captured++;
+        }
+        xioctl(fd, VIDIOC_QBUF, &buffer);
+    }
+#endif
+}
+
+void V4L2Source::copyFrame(const unsigned char* data, size_t size, ofPixels& pixels) const {
+    // Rows may be padded in the driver's buffer, NV12's chroma plane follows the luma rows with the same padding
+    const size_t rowBytes = format == OF_PIXELS_YUY2 ? width * 2 : width;
+    const size_t rows = format == OF_PIXELS_YUY2 ? height : height + height / 2;
+    unsigned char* out = pixels.getData();
+    if (bytesPerLine == rowBytes) {
+        memcpy(out, data, std::min(size, pixels.getTotalBytes()));
+        return;
+    }
+    for (size_t row = 0; row < rows && row * bytesPerLine + rowBytes <= size; ++row) {
+        memcpy(out + row * rowBytes, data + row * bytesPerLine, rowBytes);
+    }
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "ofMain.h"
+#include "FrameSource.h"
+#include "TripleBuffer.h"
+
+// Linux camera capture straight from V4L2, without ofVideoGrabber's CPU
+// conversion to RGB. Frames stay YUY2 or NV12, whichever the camera offers at
+// the requested size: a capture thread dequeues the driver's mmap buffers,
+// copies the frame out and requeues the buffer right away, and update()
+// picks up the newest copy. YuvConverter and InputPreprocessor convert on
+// the way to the screen and the detector. Other platforms fail setup().
+class V4L2Source : public FrameSource, public ofThread {
+public:
+    explicit V4L2Source(const string& device = "/dev/video0");
+    ~V4L2Source();
+
+    bool setup(int width, int height, float frameRate) override;
+    void update() override;
+    bool isFrameNew() const override { return frameNew; }
+    const ofPixels& getPixels() const override { return frames.getReadBuffer(); }
+    int getWidth() const override { return width; }
+    int getHeight() const override { return height; }
+    bool isInitialized() const override { return fd >= 0; }
+    void close() override;
+
+    uint64_t getNumCaptured() const { return captured; }
+    uint64_t getNumDropped() const { return dropped; } // Captured but replaced before update() saw them
+
+    static const int NUM_BUFFERS = 4; // Driver buffers, the camera keeps filling the others during a copy
+
+protected:
+    void threadedFunction() override;
+
+private:
+    struct Buffer {
+        void* start;
+        size_t length;
+    };
+
+    void copyFrame(const unsigned char* data, size_t size, ofPixels& pixels) const;
+
+    string device;
+    int fd = -1;
+    vector<Buffer> buffers;
+    int width = 0, height = 0;
+    size_t bytesPerLine = 0;
+    ofPixelFormat format = OF_PIXELS_UNKNOWN;
+
+    TripleBuffer<ofPixels> frames;
+    bool frameNew = false;
+    std::atomic<uint64_t> captured{0}, dropped{0};
+};
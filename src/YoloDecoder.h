@@ -0,0 +1,155 @@
+#pragma once
+
+#include <algorithm>
+#include <cfloat>
+#include <vector>
+
+#if defined(__AVX2__) || defined(__SSE2__) || defined(_M_X64)
+	#include <immintrin.h>
+#elif defined(__ARM_NEON)
+	#include <arm_neon.h>
+#endif
+
+/// \class YoloDecoder
+/// \brief allocation-free decoder for raw YOLO output rows with native NMS
+///
+/// each output row is 4 box coords (y1, x1, y2, x2) followed by one score per
+/// class; rows are read in place, the best class is found with SIMD and rows
+/// below the confidence threshold are dropped before any further work
+///
+/// all buffers are reused between calls, so after the first few frames decode()
+/// does not allocate
+class YoloDecoder {
+	public:
+
+		/// single decoded box
+		struct Detection {
+			float y1, x1, y2, x2; ///< box corners as stored in the output row
+			float confidence;     ///< best class score
+			int classIndex;       ///< best class index
+		};
+
+		/// set the number of class scores per row
+		void setup(int numClasses) {
+			numClasses_ = numClasses;
+		}
+
+		/// returns the number of class scores per row
+		int getNumClasses() const {return numClasses_;}
+
+		/// only keep rows whose best class over all classes is one of these
+		/// class indices, an empty list keeps every class (default)
+		void setClassMask(const std::vector<int> & classes) {
+			classMask_ = classes;
+		}
+
+		/// returns the class indices considered, empty when all are
+		const std::vector<int> & getClassMask() const {return classMask_;}
+
+		/// decode numRows output rows and run non-maximum suppression,
+		/// keeping at most maxDetections boxes with scores >= threshold
+		/// the returned reference stays valid until the next call
+		const std::vector<Detection> & decode(const float * data, size_t numRows, float threshold,
+		                                      size_t maxDetections=10, float iouThreshold=0.5) {
+			const size_t rowSize = 4 + numClasses_;
+			candidates_.clear();
+			for(size_t i = 0; i < numRows; i++) {
+				const float * row = data + rowSize * i;
+				const float * scores = row + 4;
+				float confidence = maxScore(scores, numClasses_);
+				if(confidence < threshold) {continue;} // early cutoff
+				int classIndex = std::find(scores, scores + numClasses_, confidence) - scores;
+				if(!classMask_.empty() && std::find(classMask_.begin(), classMask_.end(), classIndex) == classMask_.end()) {
+					continue; // another class wins this row, even if a wanted class scores above the threshold
+				}
+				candidates_.push_back({row[0], row[1], row[2], row[3], confidence, classIndex});
+			}
+			suppress(maxDetections, iouThreshold);
+			return results_;
+		}
+
+		/// returns the results of the last decode()
+		const std::vector<Detection> & getDetections() const {return results_;}
+
+		/// number of rows which passed the confidence cutoff in the last decode()
+		size_t getNumCandidates() const {return candidates_.size();}
+
+	protected:
+
+		/// greedy, class agnostic NMS over candidates_ into results_
+		void suppress(size_t maxDetections, float iouThreshold) {
+			std::sort(candidates_.begin(), candidates_.end(), [](const Detection & a, const Detection & b) {
+				return a.confidence > b.confidence;
+			});
+			results_.clear();
+			for(const Detection & candidate : candidates_) {
+				if(results_.size() >= maxDetections) {break;}
+				bool keep = true;
+				for(const Detection & kept : results_) {
+					if(iou(candidate, kept) > iouThreshold) {
+						keep = false;
+						break;
+					}
+				}
+				if(keep) {
+					results_.push_back(candidate);
+				}
+			}
+		}
+
+		/// intersection over union, corners may be in either order
+		static float iou(const Detection & a, const Detection & b) {
+			float ay1 = std::min(a.y1, a.y2), ay2 = std::max(a.y1, a.y2);
+			float ax1 = std::min(a.x1, a.x2), ax2 = std::max(a.x1, a.x2);
+			float by1 = std::min(b.y1, b.y2), by2 = std::max(b.y1, b.y2);
+			float bx1 = std::min(b.x1, b.x2), bx2 = std::max(b.x1, b.x2);
+			float areaA = (ay2 - ay1) * (ax2 - ax1);
+			float areaB = (by2 - by1) * (bx2 - bx1);
+			if(areaA <= 0 || areaB <= 0) {return 0;}
+			float h = std::max(0.f, std::min(ay2, by2) - std::max(ay1, by1));
+			float w = std::max(0.f, std::min(ax2, bx2) - std::max(ax1, bx1));
+			float intersection = h * w;
+			return intersection / (areaA + areaB - intersection);
+		}
+
+		/// max over count scores
+		static float maxScore(const float * scores, int count) {
+			int i = 0;
+		#if defined(__AVX2__)
+			__m256 max8 = _mm256_set1_ps(-FLT_MAX);
+			for(; i + 8 <= count; i += 8) {
+				max8 = _mm256_max_ps(max8, _mm256_loadu_ps(scores + i));
+			}
+			__m128 max4 = _mm_max_ps(_mm256_castps256_ps128(max8), _mm256_extractf128_ps(max8, 1));
+			max4 = _mm_max_ps(max4, _mm_movehl_ps(max4, max4));
+			max4 = _mm_max_ss(max4, _mm_shuffle_ps(max4, max4, 1));
+			float max = _mm_cvtss_f32(max4);
+		#elif defined(__SSE2__) || defined(_M_X64)
+			__m128 max4 = _mm_set1_ps(-FLT_MAX);
+			for(; i + 4 <= count; i += 4) {
+				max4 = _mm_max_ps(max4, _mm_loadu_ps(scores + i));
+			}
+			max4 = _mm_max_ps(max4, _mm_movehl_ps(max4, max4));
+			max4 = _mm_max_ss(max4, _mm_shuffle_ps(max4, max4, 1));
+			float max = _mm_cvtss_f32(max4);
+		#elif defined(__ARM_NEON) && defined(__aarch64__)
+			float32x4_t max4 = vdupq_n_f32(-FLT_MAX);
+			for(; i + 4 <= count; i += 4) {
+				max4 = vmaxq_f32(max4, vld1q_f32(scores + i));
+			}
+			float max = vmaxvq_f32(max4);
+		#else
+			float max = -FLT_MAX;
+		#endif
+			for(; i < count; i++) { // remainder and scalar fallback
+				max = std::max(max, scores[i]);
+			}
+			return max;
+		}
+
+	private:
+		int numClasses_ = 80; ///< class scores per row
+		std::vector<int> classMask_; ///< class indices to consider, empty for all
+		std::vector<Detection> candidates_; ///< rows above threshold
+		std::vector<Detection> results_; ///< rows kept by NMS
+};
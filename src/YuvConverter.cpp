@@ -0,0 +1,176 @@
+#include "YuvConverter.h"
+
+namespace {
+    const char* VERTEX_LEGACY = R"(
+        #version 120
+        varying vec2 pixel;
+        void main() {
+            pixel = gl_MultiTexCoord0.xy;
+            gl_Position = ftransform();
+        }
+    )";
+
+    const char* VERTEX_PROGRAMMABLE = R"(
+        #version 150
+        uniform mat4 modelViewProjectionMatrix;
+        in vec4 position;
+        in vec2 texcoord;
+        out vec2 pixel;
+        void main() {
+            pixel = texcoord;
+            gl_Position = modelViewProjectionMatrix * position;
+        }
+    )";
+
+    const char* FRAGMENT_LEGACY = R"(
+        #version 120
+        #extension GL_ARB_texture_rectangle : enable
+        #define IN varying
+        #define FETCH texture2DRect
+        #define OUT gl_FragColor
+    )";
+
+    const char* FRAGMENT_PROGRAMMABLE = R"(
+        #version 150
+        #define IN in
+        #define FETCH texture
+        out vec4 fragColor;
+        #define OUT fragColor
+    )";
+
+    // Fetches the frame's bytes texel by texel, the texture holds one byte per texel
+    const char* FRAGMENT = R"(
+        uniform sampler2DRect yuv;
+        uniform int nv12;      // 0 for YUY2
+        uniform float height;  // Frame height, NV12's interleaved chroma plane starts below the luma plane
+        IN vec2 pixel;         // Output pixel
+        void main() {
+            vec2 p = floor(pixel);
+            float y, u, v;
+            if (nv12 == 1) {
+                vec2 chroma = vec2(floor(p.x * 0.5) * 2.0, height + floor(p.y * 0.5));
+                y = FETCH(yuv, p + 0.5).r;
+                u = FETCH(yuv, chroma + vec2(0.5, 0.5)).r;
+                v = FETCH(yuv, chroma + vec2(1.5, 0.5)).r;
+            } else {
+                float pair = floor(p.x * 0.5) * 4.0; // Y0 U Y1 V
+                y = FETCH(yuv, vec2(p.x * 2.0 + 0.5, p.y + 0.5)).r;
+                u = FETCH(yuv, vec2(pair + 1.5, p.y + 0.5)).r;
+                v = FETCH(yuv, vec2(pair + 3.5, p.y + 0.5)).r;
+            }
+            y = 1.164 * (y - 16.0 / 255.0);
+            u -= 128.0 / 255.0;
+            v -= 128.0 / 255.0;
+            OUT = vec4(y + 1.596 * v, y - 0.392 * u - 0.813 * v, y + 2.017 * u, 1.0);
+        }
+    )";
+
+    // BT.601 limited range
+    inline unsigned char luma(int r, int g, int b) { return 16 + ((66 * r + 129 * g + 25 * b + 128) >> 8); }
+    inline unsigned char chromaU(int r, int g, int b) { return 128 + ((-38 * r - 74 * g + 112 * b + 128) >> 8); }
+    inline unsigned char chromaV(int r, int g, int b) { return 128 + ((112 * r - 94 * g - 18 * b + 128) >> 8); }
+}
+
+void YuvConverter::fromRgb(const ofPixels& rgb, ofPixelFormat format, ofPixels& yuv) {
+    int width = rgb.getWidth() & ~1;
+    int height = rgb.getHeight() & ~1;
+    if (yuv.getWidth() != static_cast<size_t>(width) || yuv.getHeight() != static_cast<size_t>(height) || yuv.getPixelFormat() != format) {
+        yuv.allocate(width, height, format);
+    }
+
+    const unsigned char* data = rgb.getData();
+    const size_t stride = rgb.getBytesStride();
+    const int bytesPerPixel = rgb.getBytesPerPixel();
+    const int r = rgb.getPixelFormat() == OF_PIXELS_BGR || rgb.getPixelFormat() == OF_PIXELS_BGRA ? 2 : 0;
+    const int b = 2 - r;
+    unsigned char* out = yuv.getData();
+
+    if (format == OF_PIXELS_YUY2) {
+        // Y0 U Y1 V per horizontal pixel pair, chroma from the pair's average
+        for (int y = 0; y < height; ++y) {
+            const unsigned char* p = data + y * stride;
+            for (int x = 0; x < width; x += 2, p += 2 * bytesPerPixel, out += 4) {
+                const unsigned char* q = p + bytesPerPixel;
+                int sr = (p[r] + q[r]) >> 1, sg = (p[1] + q[1]) >> 1, sb = (p[b] + q[b]) >> 1;
+                out[0] = luma(p[r], p[1], p[b]);
+                out[1] = chromaU(sr, sg, sb);
+                out[2] = luma(q[r], q[1], q[b]);
+                out[3] = chromaV(sr, sg, sb);
+            }
+        }
+        return;
+    }
+
+    // NV12: the luma plane, then interleaved U V for every 2x2 block
+    unsigned char* uv = out + width * height;
+    for (int y = 0; y < height; y += 2) {
+        const unsigned char* p0 = data + y * stride;
+        const unsigned char* p1 = p0 + stride;
+        unsigned char* y0 = out + y * width;
+        unsigned char* y1 = y0 + width;
+        for (int x = 0; x < width; x += 2, p0 += 2 * bytesPerPixel, p1 += 2 * bytesPerPixel) {
+            const unsigned char* q0 = p0 + bytesPerPixel;
+            const unsigned char* q1 = p1 + bytesPerPixel;
+            *y0++ = luma(p0[r], p0[1], p0[b]);
+            *y0++ = luma(q0[r], q0[1], q0[b]);
+            *y1++ = luma(p1[r], p1[1], p1[b]);
+            *y1++ = luma(q1[r], q1[1], q1[b]);
+            int sr = (p0[r] + q0[r] + p1[r] + q1[r]) >> 2;
+            int sg = (p0[1] + q0[1] + p1[1] + q1[1]) >> 2;
+            int sb = (p0[b] + q0[b] + p1[b] + q1[b]) >> 2;
+            *uv++ = chromaU(sr, sg, sb);
+            *uv++ = chromaV(sr, sg, sb);
+        }
+    }
+}
+
+void YuvConverter::convert(const ofTexture& yuv, ofPixelFormat format, int width, int height) {
+    if (failed || !yuv.isAllocated() || (!loaded && !setup())) {
+        return;
+    }
+    if (fbo.getWidth() != width || fbo.getHeight() != height) {
+        fbo.allocate(width, height, GL_RGB);
+
+        // One quad over the whole frame, texture coordinates are output pixels
+        quad.clear();
+        quad.setMode(OF_PRIMITIVE_TRIANGLE_STRIP);
+        quad.addVertex(glm::vec3(0, 0, 0));
+        quad.addTexCoord(glm::vec2(0, 0));
+        quad.addVertex(glm::vec3(width, 0, 0));
+        quad.addTexCoord(glm::vec2(width, 0));
+        quad.addVertex(glm::vec3(0, height, 0));
+        quad.addTexCoord(glm::vec2(0, height));
+        quad.addVertex(glm::vec3(width, height, 0));
+        quad.addTexCoord(glm::vec2(width, height));
+    }
+
+    fbo.begin();
+    shader.begin();
+    shader.setUniformTexture("yuv", yuv, 0);
+    shader.setUniform1i("nv12", format == OF_PIXELS_NV12 ? 1 : 0);
+    shader.setUniform1f("height", height);
+    quad.draw();
+    shader.end();
+    fbo.end();
+}
+
+bool YuvConverter::setup() {
+    bool programmable = ofIsGLProgrammableRenderer();
+    string fragment = string(programmable ? FRAGMENT_PROGRAMMABLE : FRAGMENT_LEGACY) + FRAGMENT;
+    if (!shader.setupShaderFromSource(GL_VERTEX_SHADER, programmable ? VERTEX_PROGRAMMABLE : VERTEX_LEGACY) ||
+        !shader.setupShaderFromSource(GL_FRAGMENT_SHADER, fragment)) {
+        ofLogError("YuvConverter") << "Failed to compile the YUV shader";
+        failed = true;
+        return false;
+    }
+    if (programmable) {
+        shader.bindDefaults();
+    }
+    if (!shader.linkProgram()) {
+        ofLogError("YuvConverter") << "Failed to link the YUV shader";
+        failed = true;
+        return false;
+    }
+    loaded = true;
+    return true;
+}
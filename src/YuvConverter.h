@@ -0,0 +1,32 @@
+#pragma once
+
+#include "ofMain.h"
+
+// YUV camera frames to RGB on the GPU. StreamingTexture uploads YUY2 and NV12
+// frames as their raw bytes in one 8-bit channel, a fragment shader converts
+// them (BT.601, limited range) into an RGB texture of the frame's size that
+// draws like any other frame. Replaces the CPU conversion ofVideoGrabber does.
+class YuvConverter {
+public:
+    static bool isYuv(ofPixelFormat format) { return format == OF_PIXELS_YUY2 || format == OF_PIXELS_NV12; }
+
+    // CPU conversion of an RGB, BGR or RGBA frame to YUY2 or NV12 in yuv,
+    // for recordings standing in for a YUV camera. Odd widths and heights are
+    // rounded down.
+    static void fromRgb(const ofPixels& rgb, ofPixelFormat format, ofPixels& yuv);
+
+    // Convert a raw frame texture uploaded by StreamingTexture, call from draw
+    void convert(const ofTexture& yuv, ofPixelFormat format, int width, int height);
+
+    // The last converted frame
+    const ofTexture& getTexture() const { return fbo.getTexture(); }
+
+private:
+    bool setup();
+
+    ofShader shader;
+    ofFbo fbo;
+    ofMesh quad;
+    bool loaded = false;
+    bool failed = false; // Shader didn't build, logged once
+};
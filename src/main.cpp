@@ -2,8 +2,46 @@
 #include "ofApp.h"
 
 //========================================================================
-int main() {
-	ofSetupOpenGL(1024, 768, OF_FULLSCREEN);
-	ofRunApp(new ofApp()); // Start the application
-}
+int main(int argc, char* argv[]) {
+	HeadlessOutput::Settings headless;
+	if (!HeadlessOutput::parseArguments(argc, argv, headless)) {
+		return EXIT_FAILURE;
+	}
+	OutputWall::Settings wall = OutputWall::loadSettings("settings.xml");
 
+	ofApp* app = new ofApp();
+	app->setOutputWall(wall);
+	if (headless.enabled) {
+		// Hidden window only for the GL context, works under Xvfb with Mesa llvmpipe
+		ofGLFWWindowSettings settings;
+		settings.setSize(320, 240);
+		settings.visible = false;
+		ofCreateWindow(settings);
+		app->setHeadless(headless);
+	} else if (wall.windows && wall.getNumOutputs() > 1) {
+		// One fullscreen window per display, output i on monitor i, sharing the
+		// main window's GL context so textures are uploaded once
+		ofGLFWWindowSettings settings;
+		settings.windowMode = OF_FULLSCREEN;
+		settings.monitor = 0;
+		auto mainWindow = ofCreateWindow(settings);
+		ofRunApp(mainWindow, std::shared_ptr<ofBaseApp>(app));
+		for (int output = 1; output < wall.getNumOutputs(); ++output) {
+			settings.monitor = output;
+			settings.shareContextWith = mainWindow;
+			auto window = ofCreateWindow(settings);
+			ofRunApp(window, std::make_shared<OutputWindow>([app, output] { app->drawOutput(output); },
+			                                                [app](int key) { app->keyPressed(key); }));
+		}
+		return ofRunMainLoop();
+	} else if (wall.getNumOutputs() > 1) {
+		// One fullscreen window across all displays, split into viewports
+		ofGLFWWindowSettings settings;
+		settings.windowMode = OF_FULLSCREEN;
+		settings.multiMonitorFullScreen = true;
+		ofCreateWindow(settings);
+	} else {
+		ofSetupOpenGL(1024, 768, OF_FULLSCREEN);
+	}
+	ofRunApp(app); // Start the application
+}
@@ -1,44 +1,98 @@
 #include "ofApp.h"
 
 void ofApp::setup() {
-    ofSetFrameRate(60);
+    if (headless) {
+        // Render as fast as possible, or at a fixed app time step for frame exact output
+        ofSetFrameRate(0);
+        ofSetVerticalSync(false);
+        if (headlessSettings.fixedStep) {
+            ofSetTimeModeFixedRate(ofGetFixedStepForFps(headlessSettings.frameRate));
+        }
+    } else {
+        ofSetFrameRate(60);
+    }
 
-    // Scale camera to display 
-    grabber.setup(3840, 2160); // 4k if available
-    grabber.setDesiredFrameRate(30); // Set webcam framerate to 30fps
-    grabber.update();
+    // Camera, or a raw recording standing in for it, chosen in settings.xml.
+    // Threads inherit the cores of the thread that starts them, so capture
+    // and inference threads, including the runtimes' own pools, are started
+    // from their cores before the main thread settles on the render cores.
+    loadSourceSettings();
+    startupCores = ThreadAffinity::getCurrentCores();
+    pinMainThread(captureCores);
+    if (frameSourceType == "replay") {
+        ofPixelFormat convertTo = replayFormat == "yuy2" ? OF_PIXELS_YUY2 : replayFormat == "nv12" ? OF_PIXELS_NV12 : OF_PIXELS_UNKNOWN;
+        frameSource = std::make_unique<RawFrameSource>(replayFile, replayRealtime, true, convertTo);
+    } else if (frameSourceType == "v4l2") {
+        frameSource = std::make_unique<V4L2Source>(v4l2Device);
+    } else {
+        frameSource = std::make_unique<GrabberSource>(cameraDeviceId);
+    }
+    if (!frameSource->setup(3840, 2160, 30)) { // 4k at 30fps if available
+        ofLogError() << "Failed to setup frame source " << frameSourceType;
+        std::exit(EXIT_FAILURE);
+    }
+    setupExtraCameras();
 
     // Initialize diplay 
-    inputWidth = grabber.getWidth(); 
-    inputHeight = grabber.getHeight();
-
-    outputWidth = ofGetWidth();
-    outputHeight = ofGetHeight(); 
+    inputWidth = frameSource->getWidth(); 
+    inputHeight = frameSource->getHeight();
+    worldWidth = inputWidth * (1 + extraCameras.size());
+
+    // With a window per output the canvas spans all of them, otherwise the window already does.
+    // Headless renders a single output.
+    int windowColumns = wallSettings.windows ? wallSettings.columns : 1;
+    int windowRows = wallSettings.windows ? wallSettings.rows : 1;
+    outputWidth = headless ? headlessSettings.width : ofGetWidth() * windowColumns;
+    outputHeight = headless ? headlessSettings.height : ofGetHeight() * windowRows;
+    outputWall.setup(headless ? OutputWall::Settings() : wallSettings, outputWidth, outputHeight);
+    if (headless && !headlessOutput.setup(headlessSettings)) {
+        ofLogError() << "Failed to setup headless output!";
+        std::exit(EXIT_FAILURE);
+    }
 
-    // Calculate camera and display aspect ratios
-    cameraAspectRatio = inputWidth / static_cast<float>(inputHeight);
+    // Calculate camera and display aspect ratios, several cameras make one wide image
+    cameraAspectRatio = worldWidth / static_cast<float>(inputHeight);
     displayAspectRatio = outputWidth / static_cast<float>(outputHeight);
 
     if (cameraAspectRatio > displayAspectRatio) { // Camera is wider than display
         baseScale = outputHeight / static_cast<float>(inputHeight);
     } else { // Camera is taller than display
-        baseScale = outputWidth / static_cast<float>(inputWidth);
+        baseScale = outputWidth / static_cast<float>(worldWidth);
     }
 
     // Calculate new dimensions
-    imageWidth = inputWidth * baseScale;
+    imageWidth = worldWidth * baseScale;
     imageHeight = inputHeight * baseScale;
 
+    if (!extraCameras.empty()) {
+        // The cameras are drawn side by side into one texture for the grid, within the GL size limit
+        GLint maxSize = 0;
+        glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxSize);
+        float fboScale = std::min(1.0f, std::max(maxSize, 1) / static_cast<float>(worldWidth));
+        worldFbo.allocate(worldWidth * fboScale, inputHeight * fboScale, GL_RGB);
+    }
+
+    // Capture buffers shared by display and detection, plus the persistent display buffer, the recorder may hold a few more
+    framePool.allocate(4 + RawFrameRecorder::QUEUE_SIZE, inputWidth, inputHeight, frameSource->getPixels().getPixelFormat());
+    displayPixels.allocate(imageWidth, imageHeight, frameSource->getPixels().getPixelFormat());
+
+    // Cell source rects are computed in imageWidth x imageHeight space whatever the texture size
+    gridRenderers.resize(outputWall.getNumOutputs());
+    for (auto& renderer : gridRenderers) {
+        renderer.setSourceSize(imageWidth, imageHeight);
+    }
+
     showGui = true;
     gui.setup();
     gui.setPosition(0, 0);
-    gui.setSize(outputWidth * 0.375, 760);
+    gui.setSize(outputWall.getArea(0).width * 0.375, 760);
     gui.setDefaultWidth(720);
     gui.setDefaultHeight(20);
 
     // Display settings
     gui.add(displaySettings.setup("DISPLAY SETTINGS", ""));
     gui.add(flipImage.setup("Flip image", true)); 
+    gui.add(gpuScaling.setup("GPU display scaling", true));
     
     // Grid settings
     gui.add(gridSettings.setup("GRID SETTINGS", ""));
@@ -81,31 +135,62 @@ void ofApp::setup() {
 
     // Advanced Settings 
     gui.add(advancedSettings.setup("ADVANCED SETTINGS", ""));
+    gui.add(adaptiveScheduling.setup("Adaptive frameGrain", true));
+    gui.add(targetDetectionRate.setup("Target detection rate (per second)", 10, 1, 30));
+    gui.add(schedulerLabel.setup("Scheduler", "off"));
     gui.add(frameGrain.setup("Detection frameGrain", 2, 1, 6)); 
-    gui.add(pixelsResize.setup("Detction pixelsResize", 0.75, 0.2, 1.0));
+    gui.add(pixelsResize.setup("Detction pixelsResize", 1.0, 0.2, 1.0));
+    gui.add(areaFilter.setup("Detection area filter (off: bilinear)", true));
     gui.add(maxMovementThreshold.setup("maxMovementThreshold", 0.75, 0.5, 1.0));
     gui.add(minMovementThreshold.setup("minMovementThreshold", 0.05, 0.01, 0.2));
     gui.add(expiryTime.setup("expiryTime", 60000, 30000, 120000));
+    gui.add(focusExtrapolation.setup("Extrapolate focus between detections", true));
+    gui.add(latencyCompensation.setup("Extrapolate from capture time", false));
+    gui.add(flowTracking.setup("Optical flow focus tracking", true));
+    gui.add(bytesCopiedLabel.setup("Bytes copied per frame", "0"));
+    gui.add(workerStatsLabel.setup("Detection worker", ""));
+    gui.add(motionGating.setup("Skip detection while static", true));
+    gui.add(motionThreshold.setup("Motion threshold", 0.02, 0.001, 0.5));
+    gui.add(keepAliveInterval.setup("Keep-alive detection interval", 5000, 500, 60000));
+    gui.add(motionLabel.setup("Motion", ""));
+    gui.add(profiling.setup("Profiling (p: overlay)", false));
+    gui.add(profileExportInterval.setup("Profile CSV export interval (s)", 60, 0, 3600));
+    gui.add(performanceLabel.setup("Performance", ""));
+    gui.add(latencyLabel.setup("Latency", ""));
 
     // Load Saved Settings
     loadSettings();
-
-    // Initialize YOLO model 
-    if (!yolo.setup("model", "classes.txt")) { 
-        ofLogError() << "Failed to setup YOLO model!";
-        std::exit(EXIT_FAILURE);
+    displayTexture.setStreaming(streamingUpload);
+    profiler.setThreadName("main");
+    if (headless) {
+        showGui = false; // Only the grid goes to the output
     }
 
-    // Normalize object bounding box coordinates
-    yolo.setNormalize(true); 
+    // Initialize YOLO model on the backend chosen in settings.xml, inferring all cameras as one batch
+    pinMainThread(inferenceCores);
+    detector = createDetector();
+    detector->setBatchSize(1 + extraCameras.size());
+    detector->setNumThreads(inferenceIntraOpThreads, inferenceInterOpThreads);
 
-    // Initialize bigCells and offsetFactors size 
-    for (int row = 0; row < MAX_ROWS; ++row) {
-        for (int col = 0; col < MAX_COLS; ++col) {
-            bigCells[row][col] = glm::vec2(1, 1); 
-            offsetFactors[row][col] = glm::vec2(1, 1); 
-        }
-    }
+    // Start the detection thread with the loaded settings, it lives until exit().
+    // It loads and warms up the model first, the live feed shows meanwhile.
+    detectionAreaWidth = detectionAreaBottomRightX - detectionAreaTopLeftX;
+    detectionAreaHeight = detectionAreaBottomRightY - detectionAreaTopLeftY;
+    detectionArea.set(detectionAreaTopLeftX, detectionAreaTopLeftY, detectionAreaWidth, detectionAreaHeight);
+    publishDetectionConfig();
+    tracker.setup();
+    extraPreprocessors.resize(extraCameras.size());
+    detectionWorker.setup([this](FrameBatch& batch) {
+        processFrame(batch);
+    }, [this] {
+        loadDetector();
+    });
+    detectionWorker.startThread();
+    pinMainThread(renderCores);
+    ofLogNotice() << "Inference threads " << (inferenceIntraOpThreads > 0 ? ofToString(inferenceIntraOpThreads) : "default") << " intra-op, "
+                  << (inferenceInterOpThreads > 0 ? ofToString(inferenceInterOpThreads) : "default") << " inter-op of " << ThreadAffinity::getNumCores()
+                  << " cores, cores for inference " << (inferenceCores.empty() ? "all" : inferenceCores) << ", render " << (renderCores.empty() ? "all" : renderCores)
+                  << ", capture " << (captureCores.empty() ? "all" : captureCores);
 
     // Initialize gridRefreshInterval
     gridRefreshInterval = ofGetElapsedTimeMillis() + gridUpdateInterval + ofRandom(-(gridUpdateInterval * (gridUpdateIntervalUncertainty * 0.01)), (gridUpdateInterval * (gridUpdateIntervalUncertainty * 0.01)));
@@ -115,21 +200,178 @@ void ofApp::setup() {
 }
 
 void ofApp::update() {
-    grabber.update();
+    profiler.setEnabled(profiling || showProfile);
+    {
+        Profiler::Scope scope(profiler, Profiler::GRAB);
+        frameSource->update();
+    }
+    updateExtraCameras();
 
     static int frameCount; 
 
-    if (grabber.isFrameNew()) { 
-        ofPixels pixels = grabber.getPixels();
-        pixels.resize(imageWidth, imageHeight);
-        image.setFromPixels(pixels);
-        
-        if (++frameCount % frameGrain == 0) { // Drop framerate for processFrame
-            frameCount = 0; // Reset frame counter to avoid overflow
-                if (futureResult.valid() ? futureResult.wait_for(std::chrono::milliseconds(0)) == std::future_status::ready : true) {
-                futureResult = std::async(std::launch::async, &ofApp::processFrame, this, grabber.getPixels());
+    // The model failed to load on the worker thread, there's nothing to run without it
+    if (detectorFailed) {
+        ofLogError() << "Failed to setup YOLO model!";
+        ofExit(EXIT_FAILURE);
+        return;
+    }
+    if (detectorReady && !detectorReadyLogged) {
+        ofLogNotice() << "Startup: detection ready after " << detectorReadyTime << " ms (model load " << ofToString(detectorLoadMs, 0)
+                      << " ms, warm-up " << ofToString(detectorWarmUpMs, 0) << " ms)";
+        detectorReadyLogged = true;
+        // Leave the warm-up inferences out, the last setInference() may have run before the warm-up finished
+        Detector::Stats warmUpStats = detector->getStats();
+        performanceReport.setInference(warmUpStats.inferences, warmUpStats.totalInferenceMs, warmUpStats.avgInferenceMs);
+        performanceReport.reset();
+        latencyTrace.reset();
+    }
+
+    if (frameSource->isFrameNew()) { 
+        bytesCopiedLabel = ofToString(framePool.takeBytesCopied());
+
+        // One copy out of the frame source, shared by reference from here on
+        FramePool::Ref frame;
+        {
+            Profiler::Scope scope(profiler, Profiler::COPY);
+            frame = framePool.copyFrom(frameSource->getPixels());
+        }
+        if (frame) {
+            frame->captureTime = ofGetElapsedTimeMicros();
+            frame->id = ++lastFrameId;
+            if (recorder.isRecording()) {
+                recorder.add(frame); // Written on the recorder's thread, dropped if it falls behind
+            }
+
+            // Either upload the native frame and let draw() scale it, or resize on the CPU first.
+            // YUV frames are always uploaded as they are and converted on the GPU.
+            bool nativeUpload = gpuScaling || YuvConverter::isYuv(frame->pixels.getPixelFormat());
+            const ofPixels& displaySource = nativeUpload ? frame->pixels : displayPixels;
+            if (!nativeUpload) {
+                Profiler::Scope scope(profiler, Profiler::DISPLAY_RESIZE);
+                frame->pixels.resizeTo(displayPixels);
+            }
+            {
+                Profiler::Scope scope(profiler, Profiler::TEXTURE_UPLOAD);
+                displayTexture.loadData(displaySource); // Reallocates on size changes
+            }
+
+            // Accumulate motion every frame, it decides whether a detection frame is worth an inference
+            {
+                Profiler::Scope scope(profiler, Profiler::MOTION);
+                motionGate.update(frame->pixels, detectionArea);
+            }
+            if (flowTracking && extraCameras.empty()) { // The luma grid only covers the main camera
+                Profiler::Scope scope(profiler, Profiler::FLOW);
+                flowTracker.update(motionGate.getLuma(), motionGate.getGridWidth(), motionGate.getGridHeight());
+                flowHistory.push_back({frame->id, flowAnchor, flowTracker.getDisplacement()});
+                if (flowHistory.size() > 64) {
+                    flowHistory.pop_front();
+                }
+            }
+
+            if (detectorReady && ++frameCount % frameGrain == 0) { // Drop framerate for processFrame, pass-through until the model is ready
+                frameCount = 0; // Reset frame counter to avoid overflow
+                uint64_t now = ofGetElapsedTimeMillis();
+                bool motion = motionGate.isTriggered(motionThreshold);
+                for (auto& camera : extraCameras) {
+                    motion = motion || camera->motionGate.isTriggered(motionThreshold);
+                }
+                if (!motionGating || motion || now - lastInferenceTime >= static_cast<uint64_t>(keepAliveInterval)) {
+                    // This frame and each extra camera's newest, an extra camera without a frame yet leaves its slot empty
+                    FrameBatch batch;
+                    batch.add(frame);
+                    for (auto& camera : extraCameras) {
+                        batch.add(camera->latest);
+                    }
+                    detectionWorker.submit(std::move(batch)); // Replaces any batch the worker hasn't picked up yet
+                    lastInferenceTime = now;
+                } else {
+                    detectionWorker.requestTick(); // Static scene, only advance the timeouts
+                    skippedInferences++;
+                }
             }
         }
+        motionLabel = ofToString(motionGate.getScore(), 3) + ", skipped " + ofToString(skippedInferences) +
+                      ", flow points " + ofToString(flowTracker.isTracking() ? flowTracker.getPoints().size() : 0);
+
+        DetectionWorker::Stats workerStats = detectionWorker.getStats();
+        workerStatsLabel = !detectorReady ? string("loading model") : "dropped " + ofToString(workerStats.dropped) + ", queued " + ofToString(workerStats.queueDepth) +
+                           ", age " + ofToString(workerStats.avgFrameAgeMs, 1) + " ms, track " + ofToString(targetId);
+    }
+
+    // Render frame rate against inference, split by whether the worker is inferring
+    performanceReport.addFrame(ofGetLastFrameTime(), detectionWorker.isBusy());
+    Detector::Stats detectorStats = detector->getStats();
+    performanceReport.setInference(detectorStats.inferences, detectorStats.totalInferenceMs, detectorStats.avgInferenceMs);
+    performanceLabel = performanceReport.getLabel();
+
+    // Apply the newest detection result, if any
+    if (resultBuffer.update()) {
+        const DetectionResult& result = resultBuffer.getReadBuffer();
+        personDetected = result.personDetected;
+        activePersonCount = result.activePersonCount;
+        domSize = result.domSize;
+        if (result.inferenceStart > 0) { // Ticks didn't infer anything
+            LatencyTrace::Sample sample;
+            sample.frameId = result.frameId;
+            sample.captureTime = result.captureTime;
+            sample.inferenceStart = result.inferenceStart;
+            sample.resultTime = result.publishTime;
+            sample.appliedTime = ofGetElapsedTimeMicros();
+            sample.framesBehind = lastFrameId - result.frameId;
+            latencyTrace.add(sample);
+            latencyLabel = latencyTrace.getLabel();
+        }
+        if (result.activePersonCount > 0) {
+            detectedFocus = result.targetFocus;
+            detectedVelocity = result.targetVelocity;
+            // The tracks stand where the frame saw them, so also extrapolating over their delay covers the detection latency.
+            // Only an inference sets the delay, a tick carries the same focus and time and keeps it.
+            if (result.inferenceStart > 0) {
+                focusDelay = latencyCompensation ? result.trackingDelay : 0;
+            }
+            detectedFocusTime = result.focusTime - std::min(result.focusTime, focusDelay);
+            targetFocus = detectedFocus;
+
+            if (result.inferenceStart > 0) {
+                // The box is where the detected frame saw the person, carry it along the flow measured since
+                // that frame to the newest one, then re-anchor the flow points there, in luma grid samples
+                glm::vec2 moved(0);
+                if (flowTracker.isTracking()) {
+                    for (auto& sample : flowHistory) {
+                        if (sample.frameId == result.frameId && sample.anchor == flowAnchor) {
+                            moved = flowTracker.getDisplacement() - sample.displacement;
+                            break;
+                        }
+                    }
+                }
+                float step = motionGate.getStep();
+                ofRectangle box((detectionArea.x + result.targetBox.x * detectionArea.width) / step,
+                                (detectionArea.y + result.targetBox.y * detectionArea.height) / step,
+                                result.targetBox.width * detectionArea.width / step,
+                                result.targetBox.height * detectionArea.height / step);
+                box.translate(moved);
+                flowTracker.setAnchor(box);
+                flowAnchor++;
+                flowShift = moved;
+            } else if (result.targetId != targetId) {
+                flowTracker.clear(); // A tick switched to another person, the points are on the old one
+            }
+            targetId = result.targetId;
+        } else {
+            detectedVelocity = glm::vec2(0); // Nobody active, hold the last focus
+            flowTracker.clear();
+        }
+    }
+
+    // Carry targetFocus along the measured image motion, or the tracked velocity, until the next detection arrives
+    if (flowTracking && extraCameras.empty() && personDetected && flowTracker.isTracking()) {
+        glm::vec2 moved = (flowShift + flowTracker.getDisplacement()) * static_cast<float>(motionGate.getStep());
+        // The focus point is (x + w) * 0.5 of the box, so it moves half as far as the box
+        targetFocus = detectedFocus + glm::vec2(moved.x / detectionArea.width, moved.y / detectionArea.height) * 0.5f;
+    } else if (focusExtrapolation && personDetected && detectedFocusTime > 0) {
+        uint64_t elapsed = std::min(ofGetElapsedTimeMillis() - detectedFocusTime, maxExtrapolation + focusDelay);
+        targetFocus = detectedFocus + detectedVelocity * (elapsed * 0.001f);
     }
 
     // Transition timeout
@@ -175,12 +417,7 @@ void ofApp::update() {
         } else {
             rampy = ofLerp(1, 0, progress);
             if (progress == 1) {
-                for (int row = 0; row < gridRows; ++row) { // Resetting mergeCells
-                    for (int col = 0; col < gridCols; ++col) {
-                        bigCells[row][col] = glm::vec2(1, 1);
-                        offsetFactors[row][col] = glm::vec2(0, 0);
-                    }
-                }
+                gridLayout.reset(); // Resetting mergeCells and offsetCells
             }
         }
 
@@ -221,73 +458,303 @@ void ofApp::update() {
 
         detectionArea.set(detectionAreaTopLeftX, detectionAreaTopLeftY, detectionAreaWidth, detectionAreaHeight);
     }
+
+    // pixelsResize only takes effect as the area filter's sample step, keep it on the densities a step samples
+    float sampledResize = InputPreprocessor::quantizeDensity(pixelsResize);
+    if (pixelsResize != sampledResize) {
+        pixelsResize = sampledResize;
+    }
+
+    // Retune the detection cadence to the measured load, once there is any
+    if (adaptiveScheduling && detectorReady) {
+        if (!schedulerRunning) {
+            scheduler.setup(AdaptiveScheduler::Settings(), frameGrain);
+            schedulerRunning = true;
+        }
+        scheduler.setTargetDetectionRate(targetDetectionRate);
+        DetectionWorker::Stats workerStats = detectionWorker.getStats();
+        if (scheduler.update(ofGetElapsedTimeMillis(), ofGetLastFrameTime(), workerStats.processed, workerStats.processMs, skippedInferences != schedulerSkipped)) {
+            frameGrain = scheduler.getFrameGrain();
+        }
+        schedulerSkipped = skippedInferences;
+        schedulerLabel = scheduler.getDescription();
+    } else if (schedulerRunning) {
+        schedulerRunning = false;
+        schedulerLabel = "off";
+    }
+
+    // Append the timing histograms to profile.csv, 0 turns the export off
+    if (profiling && profileExportInterval > 0 && ofGetElapsedTimeMillis() - lastProfileExport >= static_cast<uint64_t>(profileExportInterval) * 1000) {
+        lastProfileExport = ofGetElapsedTimeMillis();
+        if (!profiler.exportCsv("profile.csv")) {
+            ofLogWarning() << "Failed to write profile.csv";
+        }
+        if (!latencyTrace.exportCsv("latency.csv")) {
+            ofLogWarning() << "Failed to write latency.csv";
+        }
+    }
+
+    // Hand the current settings to the detection worker
+    publishDetectionConfig();
 }
 
-void ofApp::processFrame(ofPixels pixels) {
-    pixels.crop(detectionAreaTopLeftX, detectionAreaTopLeftY, detectionAreaWidth, detectionAreaHeight);
-    
-    pixels.resize(inputWidth * pixelsResize, inputHeight * pixelsResize);
-    yolo.setInput(pixels);
-    yolo.update();
-
-    auto objects = yolo.getObjects();
-    currentTime = ofGetElapsedTimeMillis();
-    personDetected = false;
-    activePersonCount = 0;
-    domSize = 0; 
-
-    for (auto& object : objects) {
-        if (object.ident.text == "person") { // Check if object is person
-            float confidence = object.confidence;
-            if (confidence >= minConfidence) { // Check confidence
-                float size = object.bbox.width * object.bbox.height;
-                currentPosition = glm::vec2((object.bbox.x + object.bbox.width) * 0.5, (object.bbox.y + object.bbox.height) * 0.5);
-                if (size > minSize) { // Check size
-                    personDetected = true; 
-                    bool found = false;
-                    for (auto& trackedPerson : trackedPeople) {
-                        movement = glm::distance(currentPosition, trackedPerson.position);
-                        if (movement < maxMovementThreshold) { // Maximum movement threshold to be considered the same person. 
-                            if (movement > minMovementThreshold) { // Minimum movement threshold to be considered active.
-                                trackedPerson.moveTimestamp = currentTime; // Update moveTimestamp
-                            }
-                            trackedPerson.position = currentPosition; // Update position of this person
-                            trackedPerson.size = size; // Update size of this person
-                            found = true; // same person found
-                            break;
-                        }
+void ofApp::processFrame(FrameBatch& batch) {
+    // Pick up the newest settings published by the main thread
+    configBuffer.update();
+    const DetectionConfig& config = configBuffer.getReadBuffer();
+
+    profiler.setThreadName("detection");
+    Profiler::Scope processScope(profiler, Profiler::PROCESS_FRAME);
+
+    uint64_t currentTime = ofGetElapsedTimeMillis();
+
+    // Fill the result in the triple buffer's write slot, the main thread never touches it
+    DetectionResult& result = resultBuffer.getWriteBuffer();
+    result.timestamp = currentTime;
+    result.activePersonCount = 0;
+    result.domSize = 0;
+    result.inferenceStart = 0;
+
+    // Without frames (motion gate tick) keep what the last inference saw and only advance the timeouts
+    if (batch) {
+        personSeen = false;
+        tracker.clearDetections();
+
+        // Trace the batch by the main camera's frame and its oldest capture
+        result.inferenceStart = ofGetElapsedTimeMicros();
+        trackedFrameId = batch.frames[0] ? batch.frames[0]->id : 0;
+        trackedCaptureTime = result.inferenceStart;
+        for (int i = 0; i < batch.size; ++i) {
+            if (batch.frames[i]) {
+                trackedCaptureTime = std::min(trackedCaptureTime, batch.frames[i]->captureTime);
+            }
+        }
+
+        // Cameras sit side by side in world space, each one slot of 1 / numCameras wide
+        float numCameras = 1 + config.extraDetectionAreas.size();
+        int batchSize = detector->getBatchSize();
+        int camera = 0;
+        while (camera < batch.size) {
+            // Sample each camera's detection area straight from its capture buffer into its image of the model input
+            int count = 0;
+            int cameras[FrameBatch::MAX_FRAMES];
+            {
+                Profiler::Scope scope(profiler, Profiler::PREPROCESS);
+                for (; camera < batch.size && count < batchSize; ++camera) {
+                    FramePool::Ref& frame = batch.frames[camera];
+                    if (!frame) {
+                        continue;
                     }
+                    const ofRectangle& area = camera == 0 ? config.detectionArea : config.extraDetectionAreas[camera - 1];
+                    InputPreprocessor& cameraPreprocessor = camera == 0 ? preprocessor : extraPreprocessors[camera - 1];
+                    cameraPreprocessor.process(frame->pixels, area, detector->getBatchInputBuffer(count), detector->getInputWidth(), detector->getInputHeight(),
+                                               config.areaFilter ? InputPreprocessor::AREA : InputPreprocessor::BILINEAR, config.pixelsResize);
+                    frame.reset(); // Done with the capture buffer
+                    detector->setBatchInputSize(count, area.width, area.height);
+                    cameras[count++] = camera;
+                }
+            }
+            if (count == 0) {
+                break;
+            }
 
-                    if (!found) {
-                        trackedPeople.emplace_back(TrackedPerson{currentPosition, size, currentTime}); // New person, add to trackedPeople
+            // One inference for the whole batch, or per chunk if the model can't take them all
+            detector->setPreprocessedBatch(count);
+            detector->update();
+            if (profiler.isEnabled()) { // The detector times itself, split off the decode
+                Detector::Stats stats = detector->getStats();
+                profiler.record(Profiler::INFERENCE, stats.inferenceMs * 1000);
+                profiler.record(Profiler::PARSE, stats.parseMs * 1000);
+            }
+
+            for (int image = 0; image < count; ++image) {
+                for (auto& object : detector->getObjects(image)) {
+                    if (object.ident.text == "person") { // Check if object is person
+                        float confidence = object.confidence;
+                        if (confidence >= config.minConfidence) { // Check confidence
+                            float size = object.bbox.width * object.bbox.height;
+                            glm::vec2 currentPosition((object.bbox.x + object.bbox.width) * 0.5, (object.bbox.y + object.bbox.height) * 0.5);
+                            if (size > config.minSize) { // Check size
+                                personSeen = true;
+
+                                // From the camera's detection area to its slot of world space
+                                ofRectangle box = object.bbox;
+                                box.x = (cameras[image] + box.x) / numCameras;
+                                box.width /= numCameras;
+                                currentPosition.x = (cameras[image] + currentPosition.x) / numCameras;
+                                tracker.addDetection(box, currentPosition, size);
+                            }
+                        }
                     }
                 }
             }
         }
+        currentTime = ofGetElapsedTimeMillis();
+        result.timestamp = currentTime;
+
+        // Match detections to tracks, maxMovementThreshold gates a match and minMovementThreshold counts as active
+        Profiler::Scope trackingScope(profiler, Profiler::TRACKING);
+        tracker.update(currentTime, config.maxMovementThreshold, config.minMovementThreshold);
+        trackingDelay = currentTime - std::min(currentTime, trackedCaptureTime / 1000);
     }
+    result.personDetected = personSeen;
 
-    // Expire from trackedPeople 
-    trackedPeople.erase(std::remove_if(trackedPeople.begin(), trackedPeople.end(), [this](const TrackedPerson& tp) {
-        return (currentTime - tp.moveTimestamp) > expiryTime;
-    }), trackedPeople.end());
+    // Expire tracks that haven't moved
+    tracker.expire(currentTime, config.expiryTime);
 
     // Find largest active person
-    for (auto& trackedPerson : trackedPeople) { // Checking if this person is still active
-        if ((currentTime - trackedPerson.moveTimestamp) < inactiveTimeout) {
-            activePersonCount++; 
-            if (trackedPerson.size > domSize) {
-                domSize = trackedPerson.size;
-                targetFocus = trackedPerson.position;
+    result.targetId = 0;
+    for (auto& track : tracker.getTracks()) { // Checking if this person is still active
+        if ((currentTime - track.moveTimestamp) < static_cast<uint64_t>(config.inactiveTimeout)) {
+            result.activePersonCount++;
+            if (track.size > result.domSize) {
+                result.domSize = track.size;
+                // As filtered at the last inference, main extrapolates it with its cap, a tick must not move it
+                result.targetFocus = track.position;
+                result.focusTime = track.updateTime;
+                result.targetVelocity = track.velocity;
+                result.targetId = track.id;
+                result.targetBox = track.box;
             }   
         } 
     }
 
-    if (activePersonCount <= 0 || activePersonCount > 99) {
-        activePersonCount =  0; 
-        personDetected = false; 
+    if (result.activePersonCount <= 0 || result.activePersonCount > 99) {
+        result.activePersonCount = 0;
+        result.personDetected = false;
+    }
+
+    result.frameId = trackedFrameId;
+    result.captureTime = trackedCaptureTime;
+    result.trackingDelay = trackingDelay;
+    result.version = ++resultVersion;
+    result.publishTime = ofGetElapsedTimeMicros();
+    resultBuffer.publish();
+}
+
+// Pin the main thread to a core list from settings.xml, an empty list goes back to the startup cores
+void ofApp::pinMainThread(const string& cores) {
+    if (inferenceCores.empty() && renderCores.empty() && captureCores.empty()) {
+        return; // Pinning is off
+    }
+    vector<int> coreList;
+    if (!ThreadAffinity::parseCores(cores, coreList)) {
+        return;
+    }
+    ThreadAffinity::pinCurrentThread(coreList.empty() ? startupCores : coreList);
+}
+
+void ofApp::setupExtraCameras() {
+    for (auto& cameraPointer : extraCameras) {
+        ExtraCamera& camera = *cameraPointer;
+        if (camera.source == "replay") {
+            camera.frameSource = std::make_unique<RawFrameSource>(camera.replayFile, replayRealtime, true);
+        } else if (camera.source == "v4l2") {
+            camera.frameSource = std::make_unique<V4L2Source>(camera.device);
+        } else {
+            camera.frameSource = std::make_unique<GrabberSource>(camera.deviceId);
+        }
+        if (!camera.frameSource->setup(3840, 2160, 30)) {
+            ofLogError() << "Failed to setup extra camera " << camera.source;
+            std::exit(EXIT_FAILURE);
+        }
+
+        int width = camera.frameSource->getWidth();
+        int height = camera.frameSource->getHeight();
+        camera.detectionArea = camera.detectionArea.isEmpty() ? ofRectangle(0, 0, width, height)
+                                                               : camera.detectionArea.getIntersection(ofRectangle(0, 0, width, height));
+        camera.framePool.allocate(4, width, height, camera.frameSource->getPixels().getPixelFormat());
+        camera.texture.setStreaming(streamingUpload);
+    }
+}
+
+void ofApp::updateExtraCameras() {
+    for (auto& camera : extraCameras) {
+        camera->frameSource->update();
+        if (!camera->frameSource->isFrameNew()) {
+            continue;
+        }
+        // Drop the previous frame first, the detection worker may still hold it
+        camera->latest.reset();
+        camera->latest = camera->framePool.copyFrom(camera->frameSource->getPixels());
+        if (!camera->latest) {
+            continue;
+        }
+        camera->latest->captureTime = ofGetElapsedTimeMicros();
+        camera->latest->id = ++camera->lastFrameId;
+        camera->texture.loadData(camera->latest->pixels); // Always native, scaled when drawn into worldFbo
+        camera->motionGate.update(camera->latest->pixels, camera->detectionArea);
     }
 }
 
+std::unique_ptr<Detector> ofApp::createDetector() {
+#ifdef BLOWUP_NO_TENSORFLOW
+    // ONNX Runtime is the only backend built, loadDetector() picks the model by detectorBackend
+    if (detectorBackend != "onnx") {
+        ofLogError() << "Built without TensorFlow (BLOWUP_NO_TENSORFLOW), using the onnx detector backend";
+        detectorBackend = "onnx";
+    }
+    ofLogNotice() << "Using the ONNX Runtime detector backend";
+    return std::make_unique<OnnxYolo>();
+#else
+    if (detectorBackend == "onnx") {
+#ifdef BLOWUP_ONNXRUNTIME
+        ofLogNotice() << "Using the ONNX Runtime detector backend";
+        return std::make_unique<OnnxYolo>();
+#else
+        ofLogError() << "Built without ONNX Runtime (BLOWUP_ONNXRUNTIME), using the tensorflow detector backend";
+        detectorBackend = "tensorflow"; // Load the TensorFlow model, not model.onnx
+#endif
+    }
+    ofLogNotice() << "Using the tensorflow detector backend";
+    auto yolo = std::make_unique<ofxYolo>();
+    yolo->setUseGPU(detectorUseGPU);
+    return yolo;
+#endif
+}
+
+// Run on the detection thread before its first frame, so setup() doesn't block on the model
+void ofApp::loadDetector() {
+    uint64_t start = ofGetElapsedTimeMicros();
+    if (!detector->setup(detectorBackend == "onnx" ? "model.onnx" : "model", "classes.txt")) {
+        detectorFailed = true;
+        return;
+    }
+    detectorLoadMs = (ofGetElapsedTimeMicros() - start) * 0.001f;
+
+    // Normalize object bounding box coordinates
+    detector->setNormalize(true);
+
+    // Only people matter, skip scoring the other classes
+    detector->setClassFilter({"person"});
+    if (detector->getBatchSize() <= static_cast<int>(extraCameras.size())) {
+        ofLogNotice() << "Inferring " << 1 + extraCameras.size() << " cameras in batches of " << detector->getBatchSize();
+    }
+
+    // The first inferences pay for graph initialization and allocations, not the first person walking in
+    detectorWarmUpMs = detector->warmUp();
+    detectorReadyTime = ofGetElapsedTimeMillis();
+    detectorReady = true;
+}
+
+void ofApp::publishDetectionConfig() {
+    DetectionConfig& config = configBuffer.getWriteBuffer();
+    config.detectionArea = detectionArea;
+    config.extraDetectionAreas.resize(extraCameras.size());
+    for (size_t i = 0; i < extraCameras.size(); ++i) {
+        config.extraDetectionAreas[i] = extraCameras[i]->detectionArea;
+    }
+    config.pixelsResize = pixelsResize;
+    config.areaFilter = areaFilter;
+    config.minConfidence = minConfidence;
+    config.minSize = minSize;
+    config.maxMovementThreshold = maxMovementThreshold;
+    config.minMovementThreshold = minMovementThreshold;
+    config.inactiveTimeout = inactiveTimeout;
+    config.expiryTime = expiryTime;
+    configBuffer.publish();
+}
+
 void ofApp::updateGrid() {
     float prob = ofRandom(1.0);
     if (prob < maxGridProbability * 0.01) { // Maximum grid size with given probability 
@@ -300,6 +767,7 @@ void ofApp::updateGrid() {
 
     cellWidth = outputWidth / static_cast<float>(gridCols);
     cellHeight = outputHeight / static_cast<float>(gridRows);
+    gridLayout.setGrid(gridRows, gridCols, cellWidth, cellHeight);
 }
 
 void ofApp::mergeCells() {
@@ -337,111 +805,156 @@ void ofApp::mergeCells() {
         colSpan *= bigCellScale;
         
         // Implement the merging
-        for (int r = 0; r < rowSpan; ++r) {
-            for (int c = 0; c < colSpan; ++c) {
-                if (r == 0 && c == 0) {
-                    bigCells[thisRow][thisCol] = glm::vec2(rowSpan, colSpan);
-                } else {
-                    bigCells[thisRow + r][thisCol + c] = glm::vec2(-1, -1);
-                }
-            }
-        }
+        gridLayout.merge(thisRow, thisCol, rowSpan, colSpan);
     }
 }
 
 void ofApp::offsetCells() { 
-    for (int row = 0; row < gridRows; ++row) {
-        for (int col = 0; col < gridCols; ++col) {
-            // Generate random offsets within a desired range
-            offsetFactors[row][col].x = ofRandom(-(offsetFactorX), offsetFactorX);
-            offsetFactors[row][col].y = ofRandom(-(offsetFactorY), offsetFactorY);
-        }
-    }
+    // Generate random offsets within a desired range
+    gridLayout.randomizeOffsets(offsetFactorX, offsetFactorY);
 }
 
-void ofApp::draw() { 
-    ofPushMatrix();
-    // Apply transformations to flip rendering horizontally
-    if (flipImage) {
-        ofTranslate(outputWidth, 0); // Move the origin to the mirrored position
-        ofScale(-1, 1); // Flip the X-axis
-    }
-    
-    for (int row = 0; row < gridRows; ++row) {
-        for (int col = 0; col < gridCols; ++col) {
-            
-            if (bigCells[row][col].x == -1 && bigCells[row][col].y == -1) {
-                continue; 
-            }
-
-            rowSpan = 1;
-            colSpan = 1;
-
-            if (bigCells[row][col].x > 1 || bigCells[row][col].y > 1) {
-                rowSpan = bigCells[row][col].x;
-                colSpan = bigCells[row][col].y;
-            }
+void ofApp::setHeadless(const HeadlessOutput::Settings& settings) {
+    headless = settings.enabled;
+    headlessSettings = settings;
+}
 
-            cellDrawWidth = cellWidth * colSpan;
-            cellDrawHeight = cellHeight * rowSpan;
+void ofApp::setOutputWall(const OutputWall::Settings& settings) {
+    wallSettings = settings;
+}
 
-            cellDrawAspectRatio = cellDrawWidth / cellDrawHeight; 
+void ofApp::draw() { 
+    bool offscreen = headless && !headlessOutput.isDone();
+    if (offscreen) {
+        headlessOutput.begin();
+    }
+    drawScene();
+    if (offscreen) {
+        headlessOutput.end();
+        if (headlessOutput.isDone()) {
+            ofExit();
+        }
+    }
+}
 
-            nthColX = cellWidth * col;
-            nthRowY = cellHeight * row;
+void ofApp::drawScene() {
+    Profiler::Scope drawScope(profiler, Profiler::DRAW);
 
-            if (cellDrawAspectRatio >= 1) {
-                focusWidth = (rampy * (imageWidth * scaleFactor) - 1 ) + 1;
-                focusHeight = focusWidth / cellDrawAspectRatio; 
-            } else {
-                focusHeight = (rampy * (imageHeight * scaleFactor) - 1) + 1; 
-                focusWidth = focusHeight * cellDrawAspectRatio;
+    const ofTexture* frameTexture = &getFrameTexture(displayTexture, yuvConverter, convertedSequence);
+    if (firstFrameTime == 0 && frameTexture->isAllocated()) {
+        firstFrameTime = ofGetElapsedTimeMillis();
+        ofLogNotice() << "Startup: first frame shown after " << firstFrameTime << " ms";
+    }
+    if (!extraCameras.empty()) {
+        // Every camera in its slot of world space, stretched to the main camera's size
+        float slotWidth = worldFbo.getWidth() / (1 + extraCameras.size());
+        worldFbo.begin();
+        ofClear(0, 0, 0, 255);
+        ofSetColor(255);
+        frameTexture->draw(0, 0, slotWidth, worldFbo.getHeight());
+        for (size_t i = 0; i < extraCameras.size(); ++i) {
+            ExtraCamera& camera = *extraCameras[i];
+            const ofTexture& texture = getFrameTexture(camera.texture, camera.yuvConverter, camera.convertedSequence);
+            if (texture.isAllocated()) {
+                texture.draw((i + 1) * slotWidth, 0, slotWidth, worldFbo.getHeight());
             }
+        }
+        worldFbo.end();
+        frameTexture = &worldFbo.getTexture();
+    }
 
-            offsetX = imageWidth * offsetFactors[row][col].x;
-            offsetY = imageHeight * offsetFactors[row][col].y;
-            
-            minNthFocusX = nthColX + (cellWidth * 0.5); 
-            minNthFocusY = nthRowY + (cellHeight * 0.5);
-
-            maxNthFocusX = (nthColX - ((focusWidth - cellWidth) * 0.5) + ((focusWidth * currentFocus.x) - (focusWidth * 0.5))) + offsetX;
-            maxNthFocusY = (nthRowY - ((focusHeight - cellHeight) * 0.5) + ((focusHeight * currentFocus.y) - (focusHeight * 0.5))) + offsetY;
-
-            nthFocusX = (rampy * (maxNthFocusX - minNthFocusX)) + minNthFocusX;
-            nthFocusY = (rampy * (maxNthFocusY - minNthFocusY)) + minNthFocusY;
-
-            nthFocusX = ofClamp(nthFocusX, 0, imageWidth - focusWidth);
-            nthFocusY = ofClamp(nthFocusY, 0, imageHeight - focusHeight);
-
-            image.drawSubsection(nthColX, nthRowY, cellDrawWidth, cellDrawHeight, nthFocusX, nthFocusY, focusWidth, focusHeight);
-            
-            if (cellOutlineWidth != 0) {
-                ofNoFill();
-                ofColor outlineColor(outlineR, outlineG, outlineB, 255);
-                ofSetColor(outlineColor);
-                ofSetLineWidth(cellOutlineWidth);
-                ofDrawRectangle(nthColX, nthRowY, cellDrawWidth, cellDrawHeight);
-                ofSetColor(255, 255, 255);
-            }
+    sceneTexture = frameTexture;
+
+    {
+        // One layout for the whole canvas, each output of this window draws its own cells.
+        // Other windows draw theirs from their own draw().
+        Profiler::Scope scope(profiler, Profiler::GRID);
+        gridLayout.setImage(imageWidth, imageHeight, scaleFactor);
+        gridLayout.update(rampy, currentFocus);
+        int outputs = outputWall.usesWindows() ? 1 : outputWall.getNumOutputs();
+        for (int output = 0; output < outputs; ++output) {
+            drawOutput(output);
         }
     }
-    ofPopMatrix();
+    if (outputWall.usesWindows()) {
+        glFlush(); // Submit this frame's uploads before the other contexts sample them
+    }
 
+    float guiWidth = outputWall.getArea(0).width * 0.375;
     if (showGui) {
         gui.draw();
     
         ofPushMatrix();
-        ofTranslate(outputWidth * 0.375, 0);
+        ofTranslate(guiWidth, 0);
 
-        ofScale(cameraFOVscaleFactor, cameraFOVscaleFactor);
-        grabber.draw(0, 0);
+        // All cameras fit the width of one
+        float previewScale = cameraFOVscaleFactor * inputWidth / worldWidth;
+        ofScale(previewScale, previewScale);
+        frameTexture->draw(0, 0, worldWidth, inputHeight);
 
         ofSetColor(255, 0, 0);
         ofNoFill();
         ofDrawRectangle(detectionArea);
+        for (size_t i = 0; i < extraCameras.size(); ++i) {
+            // Extra camera detection areas are in their own camera's pixels
+            const ExtraCamera& camera = *extraCameras[i];
+            float scaleX = inputWidth / static_cast<float>(camera.frameSource->getWidth());
+            float scaleY = inputHeight / static_cast<float>(camera.frameSource->getHeight());
+            ofDrawRectangle((i + 1) * inputWidth + camera.detectionArea.x * scaleX, camera.detectionArea.y * scaleY,
+                            camera.detectionArea.width * scaleX, camera.detectionArea.height * scaleY);
+        }
         ofPopMatrix();
         ofSetColor(255, 255, 255);
     }
+
+    // Timing overlay below the camera preview, or in the corner without the GUI
+    if (showProfile) {
+        if (showGui) {
+            profiler.draw(guiWidth, inputHeight * cameraFOVscaleFactor * inputWidth / worldWidth + 20);
+        } else {
+            profiler.draw(20, 20);
+        }
+    }
+}
+
+void ofApp::drawOutput(int output) {
+    if (!sceneTexture) {
+        return;
+    }
+
+    // Cells on this output, in canvas pixels before flipping
+    const ofRectangle& area = outputWall.getArea(output);
+    ofRectangle cells = area;
+    if (flipImage) {
+        cells.x = outputWidth - area.getRight();
+    }
+    GridRenderer& renderer = gridRenderers[output];
+    renderer.clear();
+    gridLayout.addCells(renderer, cells);
+
+    outputWall.begin(output);
+    // Apply transformations to flip rendering horizontally
+    if (flipImage) {
+        ofTranslate(outputWidth, 0); // Move the origin to the mirrored position
+        ofScale(-1, 1); // Flip the X-axis
+    }
+
+    // Submit all cells and outlines in one draw each
+    renderer.draw(*sceneTexture, ofColor(outlineR, outlineG, outlineB, 255), cellOutlineWidth);
+    outputWall.end();
+}
+
+// Switch to the newest frame once its upload has completed, YUV frames are converted once per upload
+const ofTexture& ofApp::getFrameTexture(StreamingTexture& texture, YuvConverter& converter, uint64_t& convertedSequence) {
+    texture.update();
+    if (!YuvConverter::isYuv(texture.getPixelFormat())) {
+        return texture.getTexture();
+    }
+    if (texture.getSequence() != convertedSequence) {
+        converter.convert(texture.getTexture(), texture.getPixelFormat(), texture.getWidth(), texture.getHeight());
+        convertedSequence = texture.getSequence();
+    }
+    return converter.getTexture();
 }
 
 void ofApp::keyPressed(int key) {
@@ -449,6 +962,19 @@ void ofApp::keyPressed(int key) {
         showGui = !showGui; // Toggle GUI visibility
     }
 
+    if (key == 'p' || key == 'P') {
+        showProfile = !showProfile; // Toggle timing overlay, records while shown
+    }
+
+    if (key == 'r' || key == 'R') {
+        if (recorder.isRecording()) {
+            recorder.stop();
+            ofLogNotice() << "Recorded " << recorder.getNumWritten() << " frames, dropped " << recorder.getNumDropped();
+        } else {
+            recorder.start("recording-" + ofGetTimestampString() + ".raw", inputWidth, inputHeight, frameSource->getPixels().getPixelFormat());
+        }
+    }
+
     if (key == 'L' && ofGetKeyPressed(OF_KEY_SHIFT)) {
         loadDefaultSettings();
     }
@@ -460,6 +986,7 @@ void ofApp::saveSettings() {
 
     // Save display settings
     settings.appendChild("flipImage").set(flipImage ? "true" : "false");
+    settings.appendChild("gpuScaling").set(gpuScaling ? "true" : "false");
     settings.appendChild("outlineR").set(outlineR.getParameter());
     settings.appendChild("outlineG").set(outlineG.getParameter());
     settings.appendChild("outlineB").set(outlineB.getParameter());
@@ -495,11 +1022,63 @@ void ofApp::saveSettings() {
     settings.appendChild("inactiveTimeout").set(inactiveTimeout.getParameter());
 
     // Save advanced settings
+    settings.appendChild("adaptiveScheduling").set(adaptiveScheduling ? "true" : "false");
+    settings.appendChild("targetDetectionRate").set(targetDetectionRate.getParameter());
     settings.appendChild("frameGrain").set(frameGrain.getParameter());
     settings.appendChild("pixelsResize").set(pixelsResize.getParameter());
+    settings.appendChild("areaFilter").set(areaFilter ? "true" : "false");
+    settings.appendChild("motionGating").set(motionGating ? "true" : "false");
+    settings.appendChild("motionThreshold").set(motionThreshold.getParameter());
+    settings.appendChild("keepAliveInterval").set(keepAliveInterval.getParameter());
     settings.appendChild("maxMovementThreshold").set(maxMovementThreshold.getParameter());
     settings.appendChild("minMovementThreshold").set(minMovementThreshold.getParameter());
     settings.appendChild("trackedPeople.erase").set(expiryTime.getParameter());
+    settings.appendChild("focusExtrapolation").set(focusExtrapolation ? "true" : "false");
+    settings.appendChild("latencyCompensation").set(latencyCompensation ? "true" : "false");
+    settings.appendChild("flowTracking").set(flowTracking ? "true" : "false");
+    settings.appendChild("profiling").set(profiling ? "true" : "false");
+    settings.appendChild("profileExportInterval").set(profileExportInterval.getParameter());
+
+    // Save detector backend, only editable in settings.xml
+    settings.appendChild("detectorBackend").set(detectorBackend);
+    settings.appendChild("detectorUseGPU").set(detectorUseGPU ? "true" : "false");
+
+    // Save frame source, only editable in settings.xml
+    settings.appendChild("frameSource").set(frameSourceType);
+    settings.appendChild("replayFile").set(replayFile);
+    settings.appendChild("replayRealtime").set(replayRealtime ? "true" : "false");
+    settings.appendChild("replayFormat").set(replayFormat);
+    settings.appendChild("v4l2Device").set(v4l2Device);
+    settings.appendChild("cameraDevice").set(cameraDeviceId);
+
+    // Save extra cameras, only editable in settings.xml
+    auto cameras = settings.appendChild("extraCameras");
+    for (auto& camera : extraCameras) {
+        auto cameraSettings = cameras.appendChild("camera");
+        cameraSettings.appendChild("source").set(camera->source);
+        cameraSettings.appendChild("deviceId").set(camera->deviceId);
+        cameraSettings.appendChild("device").set(camera->device);
+        cameraSettings.appendChild("replayFile").set(camera->replayFile);
+        cameraSettings.appendChild("detectionAreaTopLeftX").set(camera->detectionArea.getLeft());
+        cameraSettings.appendChild("detectionAreaTopLeftY").set(camera->detectionArea.getTop());
+        cameraSettings.appendChild("detectionAreaBottomRightX").set(camera->detectionArea.getRight());
+        cameraSettings.appendChild("detectionAreaBottomRightY").set(camera->detectionArea.getBottom());
+    }
+
+    // Save texture upload mode, only editable in settings.xml
+    settings.appendChild("streamingUpload").set(streamingUpload ? "true" : "false");
+
+    // Save thread budget, only editable in settings.xml
+    settings.appendChild("inferenceIntraOpThreads").set(inferenceIntraOpThreads);
+    settings.appendChild("inferenceInterOpThreads").set(inferenceInterOpThreads);
+    settings.appendChild("inferenceCores").set(inferenceCores);
+    settings.appendChild("renderCores").set(renderCores);
+    settings.appendChild("captureCores").set(captureCores);
+
+    // Save video wall outputs, only editable in settings.xml
+    settings.appendChild("outputColumns").set(wallSettings.columns);
+    settings.appendChild("outputRows").set(wallSettings.rows);
+    settings.appendChild("outputWindows").set(wallSettings.windows ? "true" : "false");
 
     xml.save("settings.xml");
 }
@@ -510,6 +1089,9 @@ void ofApp::loadSettings() {
         auto settings = xml.getChild("Settings");
 
         flipImage = settings.getChild("flipImage").getBoolValue();
+        if (settings.getChild("gpuScaling")) {
+            gpuScaling = settings.getChild("gpuScaling").getBoolValue();
+        }
         outlineR = settings.getChild("outlineR").getIntValue();
         outlineG = settings.getChild("outlineG").getIntValue();
         outlineB = settings.getChild("outlineB").getIntValue();
@@ -547,17 +1129,113 @@ void ofApp::loadSettings() {
         transOutTimeout = settings.getChild("transOutTimeout").getIntValue();
         inactiveTimeout = settings.getChild("inactiveTimeout").getIntValue();
 
+        if (settings.getChild("adaptiveScheduling")) {
+            adaptiveScheduling = settings.getChild("adaptiveScheduling").getBoolValue();
+            targetDetectionRate = settings.getChild("targetDetectionRate").getFloatValue();
+        }
         frameGrain = settings.getChild("frameGrain").getIntValue();
         pixelsResize = settings.getChild("pixelsResize").getFloatValue();
+        if (settings.getChild("areaFilter")) {
+            areaFilter = settings.getChild("areaFilter").getBoolValue();
+        }
+        if (settings.getChild("motionGating")) {
+            motionGating = settings.getChild("motionGating").getBoolValue();
+            motionThreshold = settings.getChild("motionThreshold").getFloatValue();
+            keepAliveInterval = settings.getChild("keepAliveInterval").getIntValue();
+        }
         maxMovementThreshold = settings.getChild("maxMovementThreshold").getFloatValue();
         minMovementThreshold = settings.getChild("minMovementThreshold").getFloatValue();
         expiryTime = settings.getChild("trackedPeople.erase").getIntValue();
+        if (settings.getChild("focusExtrapolation")) {
+            focusExtrapolation = settings.getChild("focusExtrapolation").getBoolValue();
+        }
+        if (settings.getChild("latencyCompensation")) {
+            latencyCompensation = settings.getChild("latencyCompensation").getBoolValue();
+        }
+        if (settings.getChild("flowTracking")) {
+            flowTracking = settings.getChild("flowTracking").getBoolValue();
+        }
+        if (settings.getChild("profiling")) {
+            profiling = settings.getChild("profiling").getBoolValue();
+            profileExportInterval = settings.getChild("profileExportInterval").getIntValue();
+        }
+
+        if (settings.getChild("detectorBackend")) {
+            detectorBackend = settings.getChild("detectorBackend").getValue();
+        }
+        if (settings.getChild("detectorUseGPU")) {
+            detectorUseGPU = settings.getChild("detectorUseGPU").getBoolValue();
+        }
+        if (settings.getChild("streamingUpload")) {
+            streamingUpload = settings.getChild("streamingUpload").getBoolValue();
+        }
+    }
+}
+
+// Read before the rest of the settings, the frame source decides the input size they depend on
+void ofApp::loadSourceSettings() {
+    ofXml xml;
+    if(xml.load("settings.xml")) {
+        auto settings = xml.getChild("Settings");
+
+        if (settings.getChild("frameSource")) {
+            frameSourceType = settings.getChild("frameSource").getValue();
+            replayFile = settings.getChild("replayFile").getValue();
+            replayRealtime = settings.getChild("replayRealtime").getBoolValue();
+        }
+        if (settings.getChild("replayFormat")) {
+            replayFormat = settings.getChild("replayFormat").getValue();
+        }
+        if (settings.getChild("v4l2Device")) {
+            v4l2Device = settings.getChild("v4l2Device").getValue();
+        }
+        if (settings.getChild("cameraDevice")) {
+            cameraDeviceId = settings.getChild("cameraDevice").getIntValue();
+        }
+        if (settings.getChild("inferenceIntraOpThreads")) {
+            inferenceIntraOpThreads = settings.getChild("inferenceIntraOpThreads").getIntValue();
+        }
+        if (settings.getChild("inferenceInterOpThreads")) {
+            inferenceInterOpThreads = settings.getChild("inferenceInterOpThreads").getIntValue();
+        }
+        if (settings.getChild("inferenceCores")) {
+            inferenceCores = settings.getChild("inferenceCores").getValue();
+        }
+        if (settings.getChild("renderCores")) {
+            renderCores = settings.getChild("renderCores").getValue();
+        }
+        if (settings.getChild("captureCores")) {
+            captureCores = settings.getChild("captureCores").getValue();
+        }
+
+        // Extra cameras, a missing detection area means the whole frame
+        extraCameras.clear();
+        for (auto& cameraSettings : settings.getChild("extraCameras").getChildren("camera")) {
+            if (1 + extraCameras.size() >= FrameBatch::MAX_FRAMES) {
+                ofLogWarning() << "Only " << FrameBatch::MAX_FRAMES << " cameras are supported";
+                break;
+            }
+            auto camera = std::make_unique<ExtraCamera>();
+            if (cameraSettings.getChild("source")) {
+                camera->source = cameraSettings.getChild("source").getValue();
+            }
+            camera->deviceId = cameraSettings.getChild("deviceId").getIntValue();
+            camera->device = cameraSettings.getChild("device").getValue();
+            camera->replayFile = cameraSettings.getChild("replayFile").getValue();
+            if (cameraSettings.getChild("detectionAreaTopLeftX")) {
+                glm::vec2 topLeft(cameraSettings.getChild("detectionAreaTopLeftX").getIntValue(), cameraSettings.getChild("detectionAreaTopLeftY").getIntValue());
+                glm::vec2 bottomRight(cameraSettings.getChild("detectionAreaBottomRightX").getIntValue(), cameraSettings.getChild("detectionAreaBottomRightY").getIntValue());
+                camera->detectionArea.set(topLeft, bottomRight);
+            }
+            extraCameras.push_back(std::move(camera));
+        }
     }
 }
 
 void ofApp::loadDefaultSettings() {
     // Reset Display settings
     flipImage = true;  // Default state for image flipping
+    gpuScaling = true;
 
     // Reset Grid settings
     outlineR = 0;
@@ -598,26 +1276,44 @@ void ofApp::loadDefaultSettings() {
     inactiveTimeout = 10000;
 
     // Reset Advanced Settings
+    adaptiveScheduling = true;
+    targetDetectionRate = 10;
+    schedulerRunning = false; // Restart from the defaults below
     frameGrain = 2;
-    pixelsResize = 0.75;
+    pixelsResize = 1.0;
+    areaFilter = true;
+    motionGating = true;
+    motionThreshold = 0.02;
+    keepAliveInterval = 5000;
     maxMovementThreshold = 0.75;
     minMovementThreshold = 0.02;
     expiryTime = 60000;
+    focusExtrapolation = true;
+    latencyCompensation = false;
+    flowTracking = true;
+    profiling = false;
+    profileExportInterval = 60;
 }
 
 
 void ofApp::exit() {
-    if (grabber.isInitialized()) {
-        grabber.close();
+    ofLogNotice() << "Performance over " << performanceReport.getSummary();
+    ofLogNotice() << "Latency over " << latencyTrace.getSummary();
+    headlessOutput.close(); // Writes the frame still being read back
+    recorder.stop();
+    if (frameSource && frameSource->isInitialized()) {
+        frameSource->close();
     }
 
     gui.clear();
 
-    if (futureResult.valid()) {
-        futureResult.get(); // Ensuring that the task is completed before exit
+    detectionWorker.shutdown(); // Joins the detection thread and releases its frames
+    for (auto& camera : extraCameras) {
+        camera->latest.reset();
+        camera->frameSource->close();
     }
 
-    trackedPeople.clear();
+    tracker.clear();
 
     saveSettings();
 }
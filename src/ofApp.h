@@ -3,17 +3,90 @@
 #include "ofMain.h"
 #include "ofxGui.h"
 #include "ofxXmlSettings.h"
-#include "ofxTensorFlow2.h"
+#include "Detector.h"
 #include "ofxYolo.h"
-#include <future>
+#include "OnnxYolo.h"
+#include "GridRenderer.h"
+#include "GridLayout.h"
+#include "StreamingTexture.h"
+#include "YuvConverter.h"
+#include "FramePool.h"
+#include "InputPreprocessor.h"
+#include "DetectionWorker.h"
+#include "TripleBuffer.h"
+#include "MotionGate.h"
+#include "AdaptiveScheduler.h"
+#include "Tracker.h"
+#include "FlowTracker.h"
+#include "Profiler.h"
+#include "PerformanceReport.h"
+#include "LatencyTrace.h"
+
+#if defined(BLOWUP_NO_TENSORFLOW) && !defined(BLOWUP_ONNXRUNTIME)
+#error "Building without TensorFlow (BLOWUP_NO_TENSORFLOW) needs the ONNX Runtime backend (BLOWUP_ONNXRUNTIME)"
+#endif
+#include "ThreadAffinity.h"
+#include "FrameSource.h"
+#include "RawFrameFile.h"
+#include "V4L2Source.h"
+#include "HeadlessOutput.h"
+#include "OutputWall.h"
 #include <vector>
 
-struct TrackedPerson {
-    glm::vec2 position;
-    float size;
-    uint64_t moveTimestamp;
+// A camera beside the main frame source, configured in settings.xml. Its frames
+// join the main camera's in one batched inference and it takes the next slot
+// to the right in world space, where the cameras sit side by side.
+struct ExtraCamera {
+    string source = "camera"; // "camera" (ofVideoGrabber), "v4l2" (V4L2Source) or "replay" (RawFrameSource)
+    int deviceId = 0;         // ofVideoGrabber device
+    string device;            // V4L2 device path
+    string replayFile;
+    ofRectangle detectionArea; // Camera pixels, empty means the whole frame
+
+    std::unique_ptr<FrameSource> frameSource;
+    FramePool framePool;
+    FramePool::Ref latest; // Newest frame, joins the next detection batch
+    uint64_t lastFrameId = 0;
+    MotionGate motionGate;
+    StreamingTexture texture;
+    YuvConverter yuvConverter;
+    uint64_t convertedSequence = 0;
+};
 
-    TrackedPerson(glm::vec2 pos, float area, uint64_t time) : position(pos), size(area), moveTimestamp(time) {}
+// Immutable snapshot of the settings the detection worker reads, published by the main thread
+struct DetectionConfig {
+    ofRectangle detectionArea;
+    std::vector<ofRectangle> extraDetectionAreas; // Per extra camera
+    float pixelsResize = 1;
+    bool areaFilter = true;
+    float minConfidence = 0;
+    float minSize = 0;
+    float maxMovementThreshold = 0;
+    float minMovementThreshold = 0;
+    int inactiveTimeout = 0;
+    int expiryTime = 0;
+};
+
+// Immutable snapshot of one detection pass, published by the detection worker
+struct DetectionResult {
+    uint64_t version = 0;   // Increments with every published result
+    uint64_t timestamp = 0; // ofGetElapsedTimeMillis() when the result was computed
+    bool personDetected = false;
+    int activePersonCount = 0;
+    float domSize = 0;
+    glm::vec2 targetFocus;  // Largest active person, only valid if activePersonCount > 0
+    uint64_t focusTime = 0; // ofGetElapsedTimeMillis() targetFocus was filtered at, its track's last update
+    glm::vec2 targetVelocity; // Its tracked velocity, per second
+    int targetId = 0;       // Its track id
+    ofRectangle targetBox;  // Its last bounding box, normalized to the detection area
+
+    // Latency tracing, ofGetElapsedTimeMicros(). A tick without frames keeps
+    // the frame of the last inference and has no inferenceStart.
+    uint64_t frameId = 0;        // Main camera frame the tracks were last updated from
+    uint64_t captureTime = 0;    // Oldest frame of that batch captured
+    uint64_t inferenceStart = 0; // Worker started on the batch, 0 for ticks
+    uint64_t publishTime = 0;    // Result published
+    uint64_t trackingDelay = 0;  // Milliseconds from that capture to the tracker update, how far the tracks lag the scene
 };
 
 class ofApp : public ofBaseApp {    
@@ -24,12 +97,31 @@ public:
     void draw() override;
     void exit() override;
 
+    // Render offscreen to HeadlessOutput instead of the window, call before ofRunApp()
+    void setHeadless(const HeadlessOutput::Settings& settings);
+
+    // Split the canvas across the outputs of a video wall, call before ofRunApp()
+    void setOutputWall(const OutputWall::Settings& settings);
+
+    // Draw one output's cells of the last drawScene(), windows beyond the first call it for theirs
+    void drawOutput(int output);
+
     void saveSettings();
     void loadSettings();
+    void loadSourceSettings();
     void loadDefaultSettings();
 
-    void processFrame(ofPixels pixels);
+    void processFrame(FrameBatch& batch);
+    void publishDetectionConfig();
+    std::unique_ptr<Detector> createDetector();
+    void loadDetector();
 
+    void pinMainThread(const string& cores);
+    void setupExtraCameras();
+    void updateExtraCameras();
+    const ofTexture& getFrameTexture(StreamingTexture& texture, YuvConverter& converter, uint64_t& convertedSequence);
+
+    void drawScene();
     void updateGrid();
     void mergeCells();
     void offsetCells();
@@ -37,26 +129,72 @@ public:
     void keyPressed(int key) override;
 
 private:
+    bool headless = false;
+    HeadlessOutput::Settings headlessSettings;
+    HeadlessOutput headlessOutput;
+    OutputWall::Settings wallSettings; // Only editable in settings.xml, read by main()
+    OutputWall outputWall;
+
     ofxPanel gui;
     bool showGui = true;
     ofxLabel displaySettings, gridSettings, animationSettings, detectionSettings, advancedSettings; 
     string settingsFile = "settings.xml";
 
-    ofVideoGrabber grabber; 
-    ofImage image;
-    ofxYolo yolo;
+    std::unique_ptr<FrameSource> frameSource;
+    string frameSourceType = "camera"; // "camera" (ofVideoGrabber), "v4l2" (V4L2Source) or "replay" (RawFrameSource)
+    string v4l2Device = "/dev/video0";
+    string replayFile = "recording.raw";
+    bool replayRealtime = true; // Replay at the recorded timing, or one frame per update
+    string replayFormat = "native"; // "yuy2" or "nv12" converts RGB recordings to stand in for a V4L2 camera
+    int cameraDeviceId = 0; // ofVideoGrabber device of the main camera
+    std::vector<std::unique_ptr<ExtraCamera>> extraCameras; // Only editable in settings.xml
+    ofFbo worldFbo; // All cameras side by side, the grid samples it when there is more than one
+    RawFrameRecorder recorder; // r: record camera frames to bin/data
+    FramePool framePool;
+    ofPixels displayPixels;
+    StreamingTexture displayTexture; // Uploads through PBOs, draws the last completed upload
+    bool streamingUpload = true; // false: synchronous uploads, for drivers with broken PBOs
+    YuvConverter yuvConverter; // YUV frames to RGB on the GPU
+    uint64_t convertedSequence = 0; // displayTexture upload yuvConverter last converted
+    std::unique_ptr<Detector> detector;
+    string detectorBackend = "tensorflow"; // "tensorflow" (ofxYolo) or "onnx" (OnnxYolo)
+    bool detectorUseGPU = true; // Let TensorFlow set GPU memory options
+    std::atomic<bool> detectorReady{false}; // Loaded and warmed up by the worker, the app shows the live feed until then
+    std::atomic<bool> detectorFailed{false};
+    std::atomic<uint64_t> detectorReadyTime{0}; // Startup metrics, ms since launch
+    std::atomic<float> detectorLoadMs{0}, detectorWarmUpMs{0};
+    uint64_t firstFrameTime = 0;
+    bool detectorReadyLogged = false;
     
     int inputWidth, inputHeight, outputWidth, outputHeight;
+    int worldWidth; // inputWidth for each camera side by side
     ofxIntField displayWidth, displayHeight;
     float cameraAspectRatio, displayAspectRatio; 
     float baseScale;
     int imageWidth, imageHeight;
     ofxToggle flipImage;
+    ofxToggle gpuScaling; // Upload native frames and scale in draw() instead of resizing on the CPU
 
     ofxIntField frameGrain;
     ofxFloatField pixelsResize;
 
-    std::future<void> futureResult; // For asynchronous frame processing
+    AdaptiveScheduler scheduler; // Drives frameGrain when adaptiveScheduling is on
+    ofxToggle adaptiveScheduling;
+    ofxFloatField targetDetectionRate;
+    ofxLabel schedulerLabel;
+    bool schedulerRunning = false;
+    uint64_t schedulerSkipped = 0;
+    ofxToggle areaFilter;
+    InputPreprocessor preprocessor;
+    std::vector<InputPreprocessor> extraPreprocessors; // Worker only, one per extra camera
+    ofxLabel bytesCopiedLabel;
+
+    DetectionWorker detectionWorker; // Runs processFrame on its own thread
+    TripleBuffer<DetectionConfig> configBuffer; // Main thread -> worker
+    TripleBuffer<DetectionResult> resultBuffer; // Worker -> main thread
+    uint64_t resultVersion = 0; // Worker only
+    uint64_t trackedFrameId = 0, trackedCaptureTime = 0, trackingDelay = 0; // Worker only, the batch the tracks were last updated from
+    ofxLabel workerStatsLabel;
 
     bool personDetected, lastPersonDetected; 
     bool pendingDetectionState;
@@ -71,6 +209,23 @@ private:
 
     glm::vec2 currentFocus;
     glm::vec2 targetFocus; 
+    ofxToggle focusExtrapolation; // Move targetFocus along the tracked velocity between detections
+    ofxToggle latencyCompensation; // Extrapolate from the detected frame's capture instead of the result, covering the detection latency
+    glm::vec2 detectedFocus, detectedVelocity;
+    uint64_t detectedFocusTime = 0;
+    uint64_t maxExtrapolation = 500; // Milliseconds past the last detection
+    uint64_t focusDelay = 0; // Milliseconds of detection latency extrapolated on top, from the last inferred result
+    int targetId = 0;
+    FlowTracker flowTracker; // Follows the focused person on the motion gate's luma grid between detections
+    struct FlowSample {
+        uint64_t frameId;
+        uint64_t anchor;
+        glm::vec2 displacement;
+    };
+    std::deque<FlowSample> flowHistory; // Displacement after each main camera frame, to carry a detection from its frame to the newest
+    uint64_t flowAnchor = 0; // Counts anchors, displacements of different anchors don't compare
+    glm::vec2 flowShift;     // Motion from the detected frame to the anchor frame, luma grid samples
+    ofxToggle flowTracking;
     ofxFloatField focusFollowSpeed; 
 
     ofRectangle cameraFOV;
@@ -80,18 +235,39 @@ private:
     int lastDetectionAreaTopLeftX, lastDetectionAreaTopLeftY, lastDetectionAreaBottomRightX, lastDetectionAreaBottomRightY;
     int detectionAreaWidth, detectionAreaHeight;
 
-    std::vector<TrackedPerson> trackedPeople;
+    Tracker tracker; // Worker only
+    bool personSeen = false; // Worker only, whether the last inference saw a person
+
+    MotionGate motionGate;
+    ofxToggle motionGating;
+    ofxFloatField motionThreshold;
+    ofxIntField keepAliveInterval;
+    uint64_t lastInferenceTime = 0;
+    uint64_t skippedInferences = 0;
+    ofxLabel motionLabel;
 
-    uint currentTime;
+    Profiler profiler; // Hot path timers, recorded while profiling is on or the overlay is shown
+    ofxToggle profiling;
+    ofxIntField profileExportInterval;
+    bool showProfile = false;
+    uint64_t lastProfileExport = 0;
+
+    // Thread budget, only editable in settings.xml
+    int inferenceIntraOpThreads = 0; // Runtime thread pool sizes, 0: the runtime's default
+    int inferenceInterOpThreads = 0;
+    string inferenceCores, renderCores, captureCores; // Core lists like "0-3,6", all empty: no pinning
+    vector<int> startupCores; // Cores the app was started on, for empty lists
+    PerformanceReport performanceReport; // Render fps with and without inference running
+    ofxLabel performanceLabel;
+    uint64_t lastFrameId = 0; // Main camera frames captured
+    LatencyTrace latencyTrace; // Capture to focus update per detection result, exported with profile.csv
+    ofxLabel latencyLabel;
 
     ofxFloatField minSize;
     float domSize; 
 
-    glm::vec2 currentPosition;
-
     ofxFloatField minConfidence; 
 
-    float movement;
     ofxFloatField maxMovementThreshold;
     ofxFloatField minMovementThreshold; 
 
@@ -99,8 +275,6 @@ private:
     ofxIntField inactiveTimeout; 
     ofxIntField expiryTime;
 
-    static const int MAX_ROWS = 256;
-    static const int MAX_COLS = 256;
     int gridRows, gridCols;
     ofxIntField minRow, minCol, maxRow, maxCol;
     ofxIntField gridUpdateInterval, gridUpdateIntervalUncertainty;
@@ -111,7 +285,10 @@ private:
     ofxIntField outlineR, outlineG, outlineB;
     ofxIntField cellOutlineWidth;
 
-    glm::vec2 bigCells[MAX_ROWS][MAX_COLS];
+    GridLayout gridLayout; // Visible cells, their merges and offsets
+    std::vector<GridRenderer> gridRenderers; // One per output, each is drawn in its own window's context
+    const ofTexture* sceneTexture = nullptr; // Texture the last drawScene() laid the grid out on
+
     int rowSpan, colSpan;
     int n1x2CellCount, n2x1CellCount, n2x2CellCount;
     ofxIntField max1x2Cell, max2x1Cell, max2x2Cell, bigCellScale;
@@ -120,15 +297,5 @@ private:
     int lastZoomFactor;
     float scaleFactor;
 
-    glm::vec2 offsetFactors[MAX_ROWS][MAX_COLS];
     ofxFloatField offsetFactorX, offsetFactorY;
-    
-    float cellDrawWidth, cellDrawHeight;
-    float cellDrawAspectRatio;
-    float nthColX, nthRowY;
-    float focusWidth, focusHeight;
-    float offsetX, offsetY;
-    float minNthFocusX, minNthFocusY;
-    float maxNthFocusX, maxNthFocusY;
-    float nthFocusX, nthFocusY;
 };
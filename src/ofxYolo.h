@@ -9,8 +9,11 @@
 
 #pragma once
 
+#ifndef BLOWUP_NO_TENSORFLOW
+
 #include "ofxTensorFlow2.h"
 #include "ofFileUtils.h"
+#include "Detector.h"
 
 /// \class ofxYOLO
 /// \brief wrapper for the YOLOv4 realtime object recognition model
@@ -18,8 +21,12 @@
 /// this model works with the COCO dataset via a textfile with one class string
 /// per line
 ///
-/// the model accepts a single input image only, the image is automatically
-/// resized to the expected input size internally
+/// setInput() accepts a single image, which is automatically resized to the
+/// expected input size internally; the preprocessed input buffer can hold a
+/// batch of images, see Detector::setBatchSize()
+///
+/// this is the TensorFlow implementation of the Detector interface, left out
+/// of builds that define BLOWUP_NO_TENSORFLOW, see config.make
 ///
 /// basic usage example:
 ///
@@ -48,7 +55,7 @@
 ///     }
 /// }
 ///
-class ofxYolo {
+class ofxYolo : public Detector {
 	public:
 
 		// model constants
@@ -57,44 +64,16 @@ class ofxYolo {
 		static const int NUM_OBJECTS = 84; ///< number of objects in output
 
 		/// single detected object
-		struct Object {
-			/// identified object class
-			struct Ident {
-				int index;          ///< identified class index within classes vector, 0 to size-1
-				std::string & text; ///< identified class string, ie. "person", "car", etc
-				Ident(int index, std::string & text) : index(index), text(text) {}
-			} ident;
-			ofRectangle bbox; ///< bounding box, coords within input image size (default) or normalized 0-1
-			float confidence; ///< confidence 0-1
-
-			/// create with identified class index and string
-			Object(int index, std::string & text) : ident(index, text) {}
-
-			/// draw object bounding box and class info
-			void draw() {
-				drawBox();
-				drawClass();
-			}
-
-			/// draw object bounding box
-			void drawBox() {
-				ofNoFill();
-				ofSetColor(ofColor::hotPink);
-				ofDrawRectangle(bbox);
-			}
-
-			/// draw object class and confidence
-			void drawClass() {
-				ofSetColor(ofColor::cyan);
-				ofDrawBitmapString(ident.text + "\n" + ofToString(confidence, 2),
-				                   bbox.x, bbox.y);
-			}
-		};
+		using Object = Detector::Object;
 
 		/// ofxTF2::ThreadedModel implementation with custom pre-processing
 		class Model : public ofxTF2::ThreadedModel {
 			public:
 				cppflow::tensor runModel(const cppflow::tensor & input) const override {
+					if(input.dtype() == TF_FLOAT) {
+						// already a preprocessed NN_W x NN_H float batch, see getInputBuffer()
+						return ofxTF2::Model::runModel(input);
+					}
 					// convert to float image and resize
 					auto inputCast = cppflow::cast(input, TF_UINT8, TF_FLOAT);
 					inputCast = cppflow::expand_dims(inputCast, 0);
@@ -102,14 +81,33 @@ class ofxYolo {
 					inputCast = cppflow::resize_bicubic(inputCast, cppflow::tensor({NN_W, NN_H}), true);
 					return ofxTF2::Model::runModel(inputCast);
 				}
+
+				/// returns the batch dimension of the model input, -1 if it is dynamic or unknown
+				int64_t getInputBatchSize(const std::string & inputName) const {
+					if(!model_) {
+						return -1;
+					}
+					auto operations = model_->get_operations();
+					if(std::find(operations.begin(), operations.end(), inputName) == operations.end()) {
+						return -1;
+					}
+					auto shape = model_->get_operation_shape(inputName);
+					return shape.empty() ? -1 : shape[0];
+				}
 		};
 
 		/// load and set up yolo model & load object class names from a txt file (one name string per line),
 		/// returns true on success
-		bool setup(const std::string & modelPath="model", const std::string & classPath="classes.txt") {
-			
+		bool setup(const std::string & modelPath="model", const std::string & classPath="classes.txt") override {
+
+			// TensorFlow sizes its thread pools from the environment when it
+			// creates its eager context, which setGPUMaxMemory() already does,
+			// so this has to come first
+			setThreadsEnv("TF_NUM_INTRAOP_THREADS", intraOpThreads_);
+			setThreadsEnv("TF_NUM_INTEROP_THREADS", interOpThreads_);
+
 			// model
-			if(!ofxTF2::setGPUMaxMemory(ofxTF2::GPU_PERCENT_70, true)) {
+			if(useGPU_ && !ofxTF2::setGPUMaxMemory(ofxTF2::GPU_PERCENT_70, true)) {
 				ofLogError("ofxYolo") << "failed to set GPU Memory options!";
 				return false;
 			}
@@ -118,33 +116,66 @@ class ofxYolo {
 			}
 			model.setup({"serving_default_input_1"}, {"StatefulPartitionedCall"});
 
-			// object classes
-			ofBuffer buffer = ofBufferFromFile(classPath);
-			if(buffer.size() == 0) {
-				ofLogError("ofxYolo") << "failed to load " << classPath;
-				return false;
-			}
-			for(auto& line : buffer.getLines()) {
-				classes_.push_back(line);
+			// batching needs a dynamic batch dimension, as in OnnxYolo fall back
+			// to one image at a time for a model exported with a fixed batch size
+			int64_t modelBatchSize = model.getInputBatchSize("serving_default_input_1");
+			if(batchSize_ > 1 && modelBatchSize > 0 && modelBatchSize != batchSize_) {
+				ofLogWarning("ofxYolo") << "model has a fixed batch size of " << modelBatchSize
+				                        << ", running images one at a time";
+				setBatchSize(1);
 			}
 
-			return true;
+			// object classes
+			return loadClasses(classPath, NUM_OBJECTS - 4);
 		}
 
 		/// clear yolo model and classes
-		void clear() {
+		void clear() override {
 			model.clear();
-			classes_.clear();
+			Detector::clear();
 		}
 
+		/// set whether to limit GPU memory growth in setup() (default true),
+		/// pointless on machines without a GPU
+		void setUseGPU(bool useGPU) {useGPU_ = useGPU;}
+
+		std::string getName() const override {return "ofxYolo";}
+		int getInputWidth() const override {return NN_W;}
+		int getInputHeight() const override {return NN_H;}
+
 		/// set input pixels to process
 		void setInput(ofPixels & pixels) {
 			input_ = ofxTF2::pixelsToTensor(pixels);
-			inputSize_.width = pixels.getWidth();
-			inputSize_.height = pixels.getHeight();
+			setBatchInputSize(0, pixels.getWidth(), pixels.getHeight());
+			inputCount_ = 1;
 			newInput_ = true;
 		}
 
+		/// returns the persistent model input buffer, batch size x NN_W x NN_H
+		/// interleaved RGB floats 0-1, allocated once on first use
+		///
+		/// write preprocessed pixels into it, then call setPreprocessedInput() or
+		/// setPreprocessedBatch(), batching needs a model with a dynamic batch
+		/// dimension, setup() falls back to a batch size of 1 otherwise;
+		/// skips the pixel tensor copy and the in-graph cast & bicubic resize
+		/// note: do not write to it while a threaded model run may still read it
+		float * getInputBuffer() override {
+			if(!inputData_) {
+				const int64_t dims[4] = {batchSize_, NN_H, NN_W, 3};
+				TF_Tensor * tensor = TF_AllocateTensor(TF_FLOAT, dims, 4, sizeof(float) * batchSize_ * NN_W * NN_H * 3);
+				inputData_ = static_cast<float *>(TF_TensorData(tensor));
+				inputTensors_.clear();
+				for(int count = 1; count < batchSize_; count++) {
+					// views of the first count images, the full batch tensor owns the buffer
+					const int64_t viewDims[4] = {count, NN_H, NN_W, 3};
+					inputTensors_.push_back(cppflow::tensor(TF_NewTensor(TF_FLOAT, viewDims, 4, inputData_,
+						sizeof(float) * count * NN_W * NN_H * 3, [](void *, size_t, void *) {}, nullptr)));
+				}
+				inputTensors_.push_back(cppflow::tensor(tensor)); // takes ownership, shares the buffer
+			}
+			return inputData_;
+		}
+
 		/// run model on current input, either synchronously by blocking until
 		/// finished or asynchronously if background thread is running
 		/// returns true if objects are new
@@ -153,25 +184,30 @@ class ofxYolo {
 		///       model quickly enough, in which case cache the input image and
 		///       do not set a new input image until the current one is finished
 		///       processing
-		bool update() {
+		bool update() override {
 			if(model.isThreadRunning()) {
 				// non-blocking
 				if(newInput_ && model.readyForInput()) {
 					model.update(input_);
 					input_ = cppflow::tensor(0); // clear
 					newInput_ = false;
+					runCount_ = inputCount_;
+					runStart_ = ofGetElapsedTimeMicros();
 				}
 				if(model.isOutputNew()) {
 					auto output = model.getOutput();
-					parseObjects(output);
+					recordInference(ofGetElapsedTimeMicros() - runStart_);
+					parseObjects(output, runCount_);
 					return true;
 				}
 			}
 			else {
 				// blocking
 				if(newInput_) {
+					uint64_t start = ofGetElapsedTimeMicros();
 					auto output = model.runModel(input_);
-					parseObjects(output);
+					recordInference(ofGetElapsedTimeMicros() - start);
+					parseObjects(output, inputCount_);
 					newInput_ = false;
 					input_ = cppflow::tensor(0); // clear
 					return true;
@@ -182,7 +218,7 @@ class ofxYolo {
 
 		/// draw detected objects within input width & height coordinate system
 		void draw() {
-			for(auto object : objects) {
+			for(auto object : getObjects()) {
 				object.draw();
 			}
 		}
@@ -200,114 +236,48 @@ class ofxYolo {
 		/// returns true if background thread is running
 		bool isThreadRunning() {return model.isThreadRunning();}
 
-		/// returns a reference to the detected objects, check the confidence
-		/// value to determine which are valid, ex. confidence > 0.5, etc
-		std::vector<Object> & getObjects() {return objects;}
-
-		/// returns a reference to the detected object class names
-		std::vector<std::string> & getClasses() {return classes_;}
-
-		/// returns input width
-		/// skeleton positions and bounding box are within this range
-		int getWidth() {return inputSize_.width;}
-
-		/// returns input height
-		/// skeleton positions and bounding box are within this range
-		int getHeight() {return inputSize_.height;}
-
-		/// set minimum object confidence threshold 0-1 (default 0.2),
-		/// anything less will be ignored
-		void setThreshold(float confidence) {
-			threshold_ = ofClamp(confidence, 0, 1);
-		}
-
-		/// get the minimum object confidence threshold 0-1
-		float getThreshold() {return threshold_;}
-
-		/// set whether to normalize object bounding box coordinates
-	    /// * true: within 0-1
-	    /// * false: within image size 0-w, 0-h (default)
-		void setNormalize(bool normalize) {normalize_ = normalize;}
-
-		/// returns true if object bounding box coordinates are normalized 0-1
-	    /// or false if within the image input size 0-w, 0-h
-		bool getNormalize() {return normalize_;}
-
 	protected:
 		Model model;
-		std::vector<Object> objects;
 
-		/// parse tensor output into object data
-		void parseObjects(const cppflow::tensor & output) {
+		using Detector::parseObjects;
 
-			// flatten output tensor to vector
-			std::vector<float> vectorOut;
-			ofxTF2::tensorToVector(output, vectorOut);
+		/// use the first count images of the input buffer as the next input
+		void submitInput(int count) override {
+			getInputBuffer();
+			input_ = inputTensors_[count - 1];
+			inputCount_ = count;
+			newInput_ = true;
+		}
 
-			// parse vector to detected rectangles
-			std::vector<float>::const_iterator first;
-			std::vector<float>::const_iterator last;
-			std::vector<int> maxElementIndexVector;
-			std::vector<float> maxElementVector;
-			std::vector<std::vector<float>> boundings;
-			std::vector<int> rectangleIndices;
-			int numRectangles = vectorOut.size() / NUM_OBJECTS;
-			std::vector<float> bound;
-			for (int i = 0; i < numRectangles; i++) {
-				first = vectorOut.begin() + NUM_OBJECTS * i;
-				last = vectorOut.begin() + NUM_OBJECTS * i + 4;
-				std::vector<float> new_vec(first, last);
-				boundings.push_back(new_vec);
-				bound.insert(bound.end(), new_vec.begin(), new_vec.end());
-				first = vectorOut.begin() + NUM_OBJECTS * i + 4;
-				last = vectorOut.begin() + NUM_OBJECTS * i + NUM_OBJECTS;
-				std::vector<float> new_vec_id(first, last);
-				int max_element_index = std::max_element(new_vec_id.begin(), new_vec_id.end()) - new_vec_id.begin();
-				float max_element = new_vec_id[max_element_index];
-				maxElementIndexVector.push_back(max_element_index);
-				maxElementVector.push_back(max_element);
+		/// set a thread count environment variable, unless count is 0
+		static void setThreadsEnv(const char * name, int count) {
+			if(count <= 0) {
+				return;
 			}
-			cppflow::tensor rectangleTensor = ofxTF2::vectorToTensor(bound, ofxTF2::shapeVector{numRectangles, 4});
-			cppflow::tensor maxElementTensor = ofxTF2::vectorToTensor(maxElementVector);
-			cppflow::tensor rectangleIndicesTensor = cppflow::non_max_suppression(rectangleTensor, maxElementTensor, 10, 0.5);
-			ofxTF2::tensorToVector(rectangleIndicesTensor, rectangleIndices);
+		#ifdef _WIN32
+			_putenv_s(name, ofToString(count).c_str());
+		#else
+			setenv(name, ofToString(count).c_str(), 1);
+		#endif
+		}
 
-			// convert detected rectangles to ofxYolo::Objects
-			objects.clear();
-			for(int index : rectangleIndices) {
-				int classIndex = maxElementIndexVector[index];
-				float confidence = maxElementVector[index];
-				if(confidence < threshold_) {continue;}
-				if(classIndex >= classes_.size()) {
-					ofLogWarning("ofxYolo") << "ignoring unknown object class index " << index;
-					continue;
-				}
-				Object object(classIndex, classes_[classIndex]);
-				if(normalize_) { // normalized bbox coords
-					object.bbox.x = boundings[index][1];
-					object.bbox.y = boundings[index][0];
-					object.bbox.width = boundings[index][3] - object.bbox.x;
-					object.bbox.height = boundings[index][2] - object.bbox.y;
-				}
-				else { // use input image size
-					object.bbox.x = boundings[index][1] * (float)inputSize_.width;
-					object.bbox.y = boundings[index][0] * (float)inputSize_.height;
-					object.bbox.width = (boundings[index][3] * (float)inputSize_.width) - object.bbox.x;
-					object.bbox.height = (boundings[index][2] * (float)inputSize_.height) - object.bbox.y;
-				}
-				object.confidence = confidence;
-				objects.push_back(object);
-			}
+		/// parse tensor output of count images into object data, reads the output tensor in place
+		void parseObjects(const cppflow::tensor & output, int count) {
+			auto tensor = output.get_tensor();
+			const float * data = static_cast<const float *>(TF_TensorData(tensor.get()));
+			size_t numRectangles = TF_TensorByteSize(tensor.get()) / (sizeof(float) * NUM_OBJECTS);
+			parseObjects(data, numRectangles, count);
 		}
 
 	private:
-		struct Size {
-			int width = 1;
-			int height = 1;
-		} inputSize_; ///< pixel input size
 		cppflow::tensor input_; ///< pixel input tensor
-		std::vector<std::string> classes_; //< known object classes
+		std::vector<cppflow::tensor> inputTensors_; ///< persistent preprocessed input tensors of 1 to batch size images
+		float * inputData_ = nullptr; ///< input buffer, owned by the full batch tensor
+		int inputCount_ = 1; ///< images in the input tensor
+		int runCount_ = 1; ///< images in the threaded model run
 		bool newInput_ = false; ///< is the input tensor new?
-	    bool normalize_ = false; ///< normalize bounding box coords?
-		float threshold_ = 0.2; ///< min object confidence threshold
+		bool useGPU_ = true; ///< set GPU memory options?
+		uint64_t runStart_ = 0; ///< threaded model run start time
 };
+
+#endif